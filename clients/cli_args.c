@@ -32,12 +32,17 @@ order_t *process_cli_args(int argc, char *argv[])
         printf("\n - Run `%s buy/sell SYMBOL AMOUNT PRICE` to send order to buy/sell shares.\n", argv[0]);
         printf("     * SYMBOL - string with values `buy` or `sell`\n");
         printf("     * AMOUNT - positive interger with possible range \n");
-        printf("     * PRICE  - positive float, truncated rounded to 2 digits after dot\n");
+        printf("     * PRICE  - positive decimal, truncated to 2 digits after dot\n");
         printf("Example: %s buy AAPL 100 100.00\n", argv[0]);
 
         // Print help to cancel order
         printf("\n - Run `%s cancel ID` to cancel the particular order.\n", argv[0]);
-        printf("     * ID     - is your unique order ID, which you can get in the list above.\n\n");
+        printf("     * ID     - is your unique order ID, which you can get in the list above.\n");
+
+        // Print help to replace order
+        printf("\n - Run `%s replace ID AMOUNT PRICE` to replace the particular order with new amount and price.\n", argv[0]);
+        printf("     * Order keeps its place in the queue, if price is the same and amount is not increased.\n");
+        printf("Example: %s replace 42 50 100.00\n\n", argv[0]);
 
         exit(0);
     }
@@ -71,10 +76,10 @@ order_t *process_cli_args(int argc, char *argv[])
             exit(1);
         }
 
-        // Check that price is positive float
-        if (strtof(argv[4], NULL) <= 0)
+        // Check that price is positive decimal
+        if (parse_price(argv[4]) == 0)
         {
-            printf("ERROR: PRICE should be positive float\n");
+            printf("ERROR: PRICE should be positive decimal\n");
             exit(1);
         }
 
@@ -89,7 +94,7 @@ order_t *process_cli_args(int argc, char *argv[])
         order->t_client = time(NULL);
         order->operation = get_operation(argv[1]);
         order->quantity = (int32_t)strtol(argv[3], NULL, 10);
-        order->price = strtof(argv[4], NULL);
+        order->price = parse_price(argv[4]);
 
         // Copy no more than 10 characters
         uint64_t copy_len = strlen(argv[2]) < 10 ? strlen(argv[2]) : 10;
@@ -109,7 +114,32 @@ order_t *process_cli_args(int argc, char *argv[])
         }
         order->t_client = time(NULL);
         order->operation = get_operation(argv[1]);
-        order->oid = strtol(argv[2], NULL, 10);
+        order->target_oid = strtol(argv[2], NULL, 10);
+
+        return order;
+    }
+
+    // Return order to replace
+    else if (argc == 5 && memcmp(argv[1], "replace", 7) == 0 && strtol(argv[2], NULL, 10) > 0)
+    {
+        // Check that amount is positive integer and price is positive decimal
+        if (strtol(argv[3], NULL, 10) <= 0 || parse_price(argv[4]) == 0)
+        {
+            printf("ERROR: AMOUNT should be positive integer and PRICE should be positive decimal\n");
+            exit(1);
+        }
+
+        order_t *order = calloc(1, sizeof(order_t));
+        if (order == NULL)
+        {
+            printf("ERROR: Unable to allocate memory for order\n");
+            exit(2);
+        }
+        order->t_client = time(NULL);
+        order->operation = get_operation(argv[1]);
+        order->target_oid = strtol(argv[2], NULL, 10);
+        order->quantity = strtol(argv[3], NULL, 10);
+        order->price = parse_price(argv[4]);
 
         return order;
     }
@@ -107,12 +107,13 @@ int main(void)
     while (1)
     {
         // Initialize message buffer
-        char client_message[MAX_MSG_LEN];
+        char client_message[MD_MAX_PAYLOAD];
         memset(client_message, '\0', sizeof(client_message));
 
         // Receive message
-        if (recvfrom(sd, client_message, sizeof(client_message), 0,
-                     (struct sockaddr *)&client_addr, &client_struct_length) < 0)
+        ssize_t recv_bytes = recvfrom(sd, client_message, sizeof(client_message), 0,
+                                      (struct sockaddr *)&client_addr, &client_struct_length);
+        if (recv_bytes < 0)
         {
             perror("Error: Cannot receive message: ");
             return 7;
@@ -128,46 +129,23 @@ int main(void)
         }
 
         // Print received message
-        printf("%s: Received message from %s:%d\n",
+        printf("%s: Received %ld bytes from %s:%d\n",
                get_human_readable_time(),
+               recv_bytes,
                exchange_ip,
                ntohs(client_addr.sin_port));
 
-        printf("Content: %s\n", client_message);
-
         // Parse message
-        order_t *order = get_orders_from_tape(client_message);
+        order_t *order = get_orders_from_market_data(client_message, recv_bytes, 0);
 
-        // Send update to Redis
-        order_t *head = order;
-        while (head)
+        // Apply the changes to Redis in the order of the tape
+        for (order_t *head = order; head != NULL; head = head->next)
         {
-            // Update orders in Redis
-            if (add_order_to_redis(red_con, head, 0) < 0)
+            if (apply_market_data_event_redis(red_con, head) < 0)
             {
                 perror("Error: Cannot update quotes: ");
                 return 8;
             }
-
-            head = head->next;
-        }
-
-        // Get the last quote time or set 0 if there is no active quote
-        uint64_t last_time;
-        if (order != NULL)
-        {
-            last_time = order->t_server;
-        }
-        else
-        {
-            last_time = 0;
-        }
-
-        // Delete quotes which are gone
-        if (delete_inactive_quotes_from_redis(red_con, last_time) < 0)
-        {
-            perror("Error: Cannot delete obsolte quotes: ");
-            return 9;
         }
 
         // Clean memory for new message
@@ -2,6 +2,7 @@
 // Preprocessor directives
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
@@ -32,7 +33,14 @@ void process_market_data_feed(
     ssize_t recv_bytes,
     char *recv_buf,
     uint64_t time_midnight,
+    md_feed_t *feed,
     redisContext *red_con);
+void process_market_data_snapshot(ssize_t recv_bytes, char *recv_buf, md_feed_t *feed, redisContext *red_con);
+void recover_market_data_gap(md_feed_t *feed, uint64_t sequence, redisContext *red_con);
+void apply_market_data_messages(md_feed_t *feed, char *packet, uint64_t length, uint64_t skip, redisContext *red_con);
+void apply_market_data_message(md_feed_t *feed, char *message, uint64_t length, char *only_symbol, redisContext *red_con);
+void apply_market_data_snapshot(md_feed_t *feed, redisContext *red_con);
+void reset_market_data_book(md_feed_t *feed, redisContext *red_con);
 
 // Define main function
 int main(void)
@@ -42,29 +50,73 @@ int main(void)
     get_or_create_uuid(client_id);
 
     // POLL: Declare variables for polling
-    struct pollfd open_fds[FOPEN_MAX];
+    struct pollfd open_fds[MAX_POLL_FDS];
     uint64_t max_fd_list_id = 0;
     uint64_t fd_ind = 0;
     int64_t fd_ready = 0;
 
     // POLL: Initialize list of pollable descriptors
-    for (uint64_t i = 0; i < FOPEN_MAX; i++)
+    for (uint64_t i = 0; i < MAX_POLL_FDS; i++)
     {
         open_fds[i].fd = -1;
     }
 
     // TCP + UDP: Get connection details for TCP and UDP connections
-    server_t *addr_mcast_group = get_server("EXCHANGE_MARKET_DATA_IP_MCAST_GROUP", "EXCHANGE_MARKET_DATA_L4_PORT", IPPROTO_UDP);
+    server_t *addr_directory = get_server("EXCHANGE_MARKET_DATA_DIRECTORY_IP", "EXCHANGE_MARKET_DATA_DIRECTORY_PORT", IPPROTO_TCP);
     server_t *addr_mcast_local = get_server("CUSTOMER_IP_ACCEPT_MCAST", "EXCHANGE_MARKET_DATA_L4_PORT", IPPROTO_UDP);
     server_t *addr_ucast_local = get_server("CUSTOMER_IP_ACCEPT_UCAST", "CUSTOMER_L4_PORT", IPPROTO_TCP);
     server_t *addr_redis = get_server("REDIS_IP", "REDIS_PORT", IPPROTO_TCP);
 
-    // TCP + UDP: Initialize buffer
+    // UDP: Directory tells the channels of the symbols of interest, only those channels are joined
+    static md_symbol_t subscribed[MD_MAX_SUBSCRIPTIONS];
+    uint64_t subscriptions = get_subscribed_symbols(subscribed);
+
+    static char directory[sizeof(md_directory_header_t) + MD_MAX_CHANNELS * sizeof(md_directory_channel_t) +
+                          MD_MAX_SUBSCRIPTIONS * sizeof(md_directory_symbol_t)];
+    uint64_t directory_length = 0;
+    if (request_market_data_directory(addr_directory, subscribed, subscriptions, directory, &directory_length) != 0)
+    {
+        return 5;
+    }
+    md_directory_header_t *directory_header = (md_directory_header_t *)directory;
+    md_directory_channel_t *channels = (md_directory_channel_t *)(directory + sizeof(md_directory_header_t));
+    md_directory_symbol_t *symbols = (md_directory_symbol_t *)(channels + bswap_16(directory_header->channels));
+
+    // UDP: Symbols are kept as the exchange names them, all channels are joined, if the customer has no symbols
+    bool joined[MD_MAX_CHANNELS];
+    memset(joined, subscriptions == 0, sizeof(joined));
+    for (uint64_t i = 0; i < subscriptions; i++)
+    {
+        memcpy(subscribed[i].symbol, symbols[i].stock, sizeof(subscribed[i].symbol) - 1);
+        joined[bswap_16(symbols[i].channel) % MD_MAX_CHANNELS] = true;
+        printf("%s | MD | Symbol %s is sent on channel %u\n",
+               get_human_readable_time(),
+               subscribed[i].symbol,
+               bswap_16(symbols[i].channel));
+    }
+
+    // UDP: Sequence of each channel is tracked, so that lost messages are requested from its retransmission service,
+    // and the recent messages are kept to be applied on top of the snapshots
+    md_feed_t *feeds = calloc(MD_MAX_CHANNELS, sizeof(md_feed_t));
+    uint64_t feed_count = 0;
+    if (feeds == NULL)
+    {
+        perror("Error: Cannot allocate memory: ");
+        return 5;
+    }
+
+    // TCP + UDP: Initialize buffer, which fits the whole market data datagram
     ssize_t recv_bytes = 0;
 
-    char recv_buf[MAX_MSG_LEN];
+    char recv_buf[MD_MAX_PAYLOAD];
     memset(recv_buf, 0, sizeof(recv_buf));
 
+    // TCP: Exchange keeps the connection open and sends notifications back to back, so a message
+    // can be split between reads. Incomplete message of each descriptor is kept until the rest arrives.
+    char og_buffers[MAX_POLL_FDS][sizeof(struct order_gateway_request_message_t)];
+    uint64_t og_buffer_lengths[MAX_POLL_FDS];
+    memset(og_buffer_lengths, 0, sizeof(og_buffer_lengths));
+
     // TCP: Initialize socket
     int64_t tcp_listed_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (tcp_listed_fd < 0)
@@ -120,77 +172,56 @@ int main(void)
     open_fds[0].fd = tcp_listed_fd;
     open_fds[0].events = POLLIN;
 
-    // UDP: Initialize socket
-    int64_t udp_listen_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (udp_listen_fd < 0)
-    {
-        perror("Error: UDP: Cannot create socket: ");
-        return 1;
-    }
-    printf("%s | GEN | UDP: socket created successfully\n", get_human_readable_time());
-
-    // UDP: Initialize server listen address (MCAST Group)
-    struct sockaddr_in udp_server_addr;
-    memset(&udp_server_addr, 0, sizeof(udp_server_addr));
-
-    udp_server_addr.sin_family = AF_INET;
-    udp_server_addr.sin_port = htons(addr_mcast_group->port);
-    if (inet_pton(udp_server_addr.sin_family, addr_mcast_group->ip, &udp_server_addr.sin_addr) < 0)
-    {
-        perror("Error: UDP: Uncompatible IP Address: ");
-        return 2;
-    }
-
-    // UDP: Allow reuse of same port as it can be used in different MCAST Groups
-    uint64_t udp_so_reuseaddr = 1;
-    if (setsockopt(udp_listen_fd, SOL_SOCKET, SO_REUSEADDR, &udp_so_reuseaddr, sizeof(udp_so_reuseaddr)) < 0)
-    {
-        perror("Error: UDP: Cannot set socket option: ");
-        return 3;
-    }
-
-    // UDP: Bind socket
-    if (bind(udp_listen_fd, (struct sockaddr *)&udp_server_addr, sizeof(udp_server_addr)) < 0)
-    {
-        perror("Error: UDP: Cannot bind socket: ");
-        return 4;
-    }
-
-    // UDP: Initialize request to join multicast (somehow <linux/in.h> doesn't work for me)
-    struct ip_mreq
-    {
-        /* IP multicast address of group.  */
-        struct in_addr imr_multiaddr;
-
-        /* Local IP address of interface.  */
-        struct in_addr imr_interface;
-    };
-    struct ip_mreq mreq;
-    memset(&mreq, 0, sizeof(mreq));
-    if (inet_pton(udp_server_addr.sin_family, addr_mcast_group->ip, &mreq.imr_multiaddr) < 0)
-    {
-        perror("Error: UDP: Uncompatible IP Address: ");
-        return 2;
-    }
-    if (inet_pton(udp_server_addr.sin_family, addr_mcast_local->ip, &mreq.imr_interface) < 0)
-    {
-        perror("Error: UDP: Uncompatible IP Address: ");
-        return 2;
-    }
-
-    // UDP: Join multicast group
-    if (setsockopt(udp_listen_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+    // UDP: Join multicast groups of the deltas and of the snapshots of each channel, retransmission service
+    // of the channel runs next to the directory
+    for (uint64_t i = 0; i < bswap_16(directory_header->channels); i++)
     {
-        perror("Error: Cannot join multicast group: ");
-        return 5;
+        uint64_t channel = bswap_16(channels[i].channel);
+        if (channel >= MD_MAX_CHANNELS || !joined[channel])
+        {
+            continue;
+        }
+        md_feed_t *feed = &feeds[feed_count++];
+        feed->channel = channel;
+        feed->subscriptions = subscriptions;
+        feed->subscribed = subscribed;
+        feed->addr_rewind = calloc(1, sizeof(server_t));
+        *feed->addr_rewind = *addr_directory;
+        feed->addr_rewind->port = bswap_16(channels[i].rewind_port);
+
+        server_t addr_mcast_group;
+        server_t addr_snapshot_group;
+        memset(&addr_mcast_group, 0, sizeof(addr_mcast_group));
+        memset(&addr_snapshot_group, 0, sizeof(addr_snapshot_group));
+        inet_ntop(AF_INET, &channels[i].group, addr_mcast_group.ip, sizeof(addr_mcast_group.ip));
+        inet_ntop(AF_INET, &channels[i].snapshot_group, addr_snapshot_group.ip, sizeof(addr_snapshot_group.ip));
+        addr_mcast_group.port = bswap_16(channels[i].port);
+        addr_snapshot_group.port = bswap_16(channels[i].snapshot_port);
+
+        int64_t udp_listen_fd = join_market_data_group(&addr_mcast_group, addr_mcast_local);
+        int64_t udp_snapshot_fd = join_market_data_group(&addr_snapshot_group, addr_mcast_local);
+        if (udp_listen_fd < 0 || udp_snapshot_fd < 0)
+        {
+            return 5;
+        }
+        printf("%s | MD | Joined channel %lu at %s @ %lu, snapshots at %s @ %lu\n",
+               get_human_readable_time(),
+               channel,
+               addr_mcast_group.ip,
+               addr_mcast_group.port,
+               addr_snapshot_group.ip,
+               addr_snapshot_group.port);
+
+        // UDP + POLL: Add sockets for polling, deltas of the channels go first, their snapshots follow them
+        open_fds[feed_count].fd = udp_listen_fd;
+        open_fds[feed_count].events = POLLIN;
+        open_fds[MD_MAX_CHANNELS + feed_count].fd = udp_snapshot_fd;
+        open_fds[MD_MAX_CHANNELS + feed_count].events = POLLIN;
     }
-
-    // UDP + POLL: Add socket for polling
-    open_fds[1].fd = udp_listen_fd;
-    open_fds[1].events = POLLIN;
+    printf("%s | GEN | UDP: sockets created successfully\n", get_human_readable_time());
 
     // POLL: Set the initial maximum descirptor array index
-    max_fd_list_id = 1;
+    max_fd_list_id = 2 * MD_MAX_CHANNELS;
 
     // REDIS: Open connection
     redisContext *red_con = redisConnect(addr_redis->ip, addr_redis->port);
@@ -231,7 +262,7 @@ int main(void)
             }
 
             // TCP + POLL: If so far successful, add new customer socket to list to the first unused position
-            for (fd_ind = 2; fd_ind < FOPEN_MAX; fd_ind++)
+            for (fd_ind = 2 * MD_MAX_CHANNELS + 1; fd_ind < MAX_POLL_FDS; fd_ind++)
             {
                 if (open_fds[fd_ind].fd < 0)
                 {
@@ -242,7 +273,7 @@ int main(void)
             }
 
             // POLL: Validate if waiting list is full
-            if (fd_ind == FOPEN_MAX)
+            if (fd_ind == MAX_POLL_FDS)
             {
                 perror("Error: POLL: Too many clients");
                 return 8;
@@ -274,7 +305,7 @@ int main(void)
             if (open_fds[fd_ind].revents & (POLLIN | POLLERR))
             {
                 // UDP: Process UDP multicast feed
-                if (fd_ind == 1)
+                if (fd_ind <= MD_MAX_CHANNELS)
                 {
                     // Initialize struct for market data source
                     struct sockaddr_in md_addr;
@@ -294,11 +325,23 @@ int main(void)
                         recv_bytes,
                         recv_buf,
                         time_midnight,
+                        &feeds[fd_ind - 1],
                         red_con);
 
                     // Cleanup the buffer
                     memset(recv_buf, 0, sizeof(recv_buf));
                 }
+                // UDP: Process UDP multicast snapshots
+                else if (fd_ind <= 2 * MD_MAX_CHANNELS)
+                {
+                    if ((recv_bytes = recv(open_fds[fd_ind].fd, recv_buf, sizeof(recv_buf), 0)) < 0)
+                    {
+                        perror("Error: UDP: Cannot receive data");
+                        return 9;
+                    }
+                    process_market_data_snapshot(recv_bytes, recv_buf, &feeds[fd_ind - MD_MAX_CHANNELS - 1], red_con);
+                    memset(recv_buf, 0, sizeof(recv_buf));
+                }
                 // TCP: Process TCP order gateway messages
                 else
                 {
@@ -313,6 +356,7 @@ int main(void)
                                 return 10;
                             }
                             open_fds[fd_ind].fd = -1;
+                            og_buffer_lengths[fd_ind] = 0;
                         }
                     }
                     // TCP: Case for connection closed by exchange
@@ -324,17 +368,34 @@ int main(void)
                             return 10;
                         }
                         open_fds[fd_ind].fd = -1;
+                        og_buffer_lengths[fd_ind] = 0;
                     }
                     // TCP: Data received as usual
                     else
                     {
-                        // Process notification
-                        process_order_gateway_notification(
-                            open_fds[fd_ind].fd,
-                            recv_bytes,
-                            recv_buf,
-                            time_midnight,
-                            red_con);
+                        // Process every complete notification in the received data
+                        for (ssize_t offset = 0; offset < recv_bytes;)
+                        {
+                            uint64_t length = sizeof(og_buffers[fd_ind]) - og_buffer_lengths[fd_ind];
+                            if (length > (uint64_t)(recv_bytes - offset))
+                            {
+                                length = recv_bytes - offset;
+                            }
+                            memcpy(og_buffers[fd_ind] + og_buffer_lengths[fd_ind], recv_buf + offset, length);
+                            og_buffer_lengths[fd_ind] += length;
+                            offset += length;
+
+                            if (og_buffer_lengths[fd_ind] == sizeof(og_buffers[fd_ind]))
+                            {
+                                process_order_gateway_notification(
+                                    open_fds[fd_ind].fd,
+                                    og_buffer_lengths[fd_ind],
+                                    og_buffers[fd_ind],
+                                    time_midnight,
+                                    red_con);
+                                og_buffer_lengths[fd_ind] = 0;
+                            }
+                        }
 
                         // Cleanup
                         memset(recv_buf, 0, sizeof(recv_buf));
@@ -352,13 +413,24 @@ int main(void)
 
     // Close socket
     close(tcp_listed_fd);
-    close(udp_listen_fd);
+    for (fd_ind = 1; fd_ind <= 2 * MD_MAX_CHANNELS; fd_ind++)
+    {
+        if (open_fds[fd_ind].fd >= 0)
+        {
+            close(open_fds[fd_ind].fd);
+        }
+    }
 
     // Close connection to Redis
     redisFree(red_con);
 
     // Clean up
-    free(addr_mcast_group);
+    for (uint64_t i = 0; i < feed_count; i++)
+    {
+        free(feeds[i].addr_rewind);
+    }
+    free(feeds);
+    free(addr_directory);
     free(addr_mcast_local);
     free(addr_ucast_local);
     free(addr_redis);
@@ -411,12 +483,13 @@ void process_order_gateway_notification(
     ogm_input.ts_placed = bswap_64(ogm_input.ts_placed);
     ogm_input.ts_executed = bswap_64(ogm_input.ts_executed);
 
-    printf("%s | OG | %s:%i | Order %lu executed at %lu \n",
+    printf("%s | OG | %s:%i | Order %lu executed at %lu (%s)\n",
            get_human_readable_time(),
            og_ip_readable,
            htons(og_addr.sin_port),
            ogm_input.order_id,
-           ogm_input.ts_executed);
+           ogm_input.ts_executed,
+           ogm_input.status == 'E' ? "filled" : "partially filled");
 
     // Get orders
     order_t *order = deserialize_exchange_confirmation_2(&ogm_input);
@@ -439,11 +512,8 @@ void process_order_gateway_notification(
            og_ip_readable,
            htons(og_addr.sin_port));
 
-    // Shutdown the connection
-    shutdown(sockfd, SHUT_WR);
-
-    // Update Redis
-    if (process_completed_order_redis(red_con, order) < 0)
+    // Update Redis once the order is fully executed, partial fills ('P') keep it open
+    if (ogm_input.status == 'E' && process_completed_order_redis(red_con, order) < 0)
     {
         perror("Error: TCP Cannot process Redis data: ");
         free(order);
@@ -458,9 +528,12 @@ void process_market_data_feed(
     ssize_t recv_bytes,
     char *recv_buf,
     uint64_t time_midnight,
+    md_feed_t *feed,
     redisContext *red_con)
 {
-    /* Helper function to process multicast feed from market data*/
+    /* Helper function to process multicast feed from market data. Messages are applied strictly in the order of
+       their sequence numbers: duplicates are passed over and the gap is filled by retransmission first.
+       The book is rebuilt from the snapshots, when the feed is joined or messages are lost. */
 
     // Get readable market data source
     char md_ip_readable[INET_ADDRSTRLEN];
@@ -472,47 +545,302 @@ void process_market_data_feed(
         exit(2);
     }
 
-    printf("%s | MD | %s:%i | MCAST: %s\n",
+    printf("%s | MD | %s:%i | MCAST: %ld bytes\n",
            get_human_readable_time(),
            md_ip_readable,
            htons(md_addr->sin_port),
-           recv_buf);
+           recv_bytes);
+
+    if (recv_bytes < (ssize_t)sizeof(md_packet_header_t))
+    {
+        printf("%s | MD | Market data datagram is too short\n", get_human_readable_time());
+        return;
+    }
+    md_packet_header_t *header = (md_packet_header_t *)recv_buf;
+    uint64_t sequence = bswap_64(header->sequence);
+    uint64_t count = bswap_16(header->count);
 
-    // Parse message
-    order_t *order = get_orders_from_tape(recv_buf);
+    // Restarted feed numbers messages from 1 again, the first session joined is followed from the first datagram seen
+    if (memcmp(header->session, feed->session, MD_SESSION_LEN) != 0)
+    {
+        printf("%s | MD | Session %.10s started on channel %lu\n", get_human_readable_time(), header->session, feed->channel);
+        feed->next_sequence = feed->next_sequence == 0 ? sequence : 1;
+        memcpy(feed->session, header->session, MD_SESSION_LEN);
+        reset_market_data_book(feed, red_con);
+    }
+
+    // Datagram was already received or its messages were recovered by retransmission
+    if (sequence + count <= feed->next_sequence)
+    {
+        return;
+    }
 
-    // Send update to Redis
-    order_t *head = order;
-    while (head)
+    // Messages lost before this datagram have to be applied first
+    if (sequence > feed->next_sequence)
     {
-        // Update orders in Redis
-        if (add_order_to_redis(red_con, head, 0) < 0)
+        recover_market_data_gap(feed, sequence, red_con);
+    }
+
+    // Messages are applied in the order of the tape
+    apply_market_data_messages(feed, recv_buf, recv_bytes, feed->next_sequence - sequence, red_con);
+    feed->next_sequence = sequence + count;
+}
+
+void process_market_data_snapshot(ssize_t recv_bytes, char *recv_buf, md_feed_t *feed, redisContext *red_con)
+{
+    /* Helper function to collect the snapshot of the symbol, which may span several datagrams, and to apply it,
+       once all its orders are received */
+    if (recv_bytes < (ssize_t)sizeof(md_packet_header_t))
+    {
+        printf("%s | MD | Market data datagram is too short\n", get_human_readable_time());
+        return;
+    }
+    md_packet_header_t *header = (md_packet_header_t *)recv_buf;
+    uint64_t sequence = bswap_64(header->sequence);
+    uint64_t count = bswap_16(header->count);
+
+    // Snapshots are useful only for the session of the deltas
+    if (memcmp(header->session, feed->session, MD_SESSION_LEN) != 0)
+    {
+        return;
+    }
+
+    // Lost datagram breaks the snapshot, the symbol is taken again in the next cycle
+    if (sequence != feed->snapshot_sequence)
+    {
+        free_order_list(feed->snapshot);
+        feed->snapshot = NULL;
+    }
+    feed->snapshot_sequence = sequence + count;
+
+    order_t *order = get_orders_from_market_data(recv_buf, recv_bytes, 0);
+    while (order != NULL)
+    {
+        order_t *next = order->next;
+        order->next = NULL;
+
+        // Snapshot message starts the symbol and is followed by its orders
+        if (order->event == MD_EVENT_SNAPSHOT)
         {
-            perror("Error: Cannot update quotes: ");
-            exit(8);
+            free_order_list(feed->snapshot);
+            feed->snapshot = order;
+            feed->snapshot_tail = order;
+            feed->snapshot_orders = order->quantity;
+        }
+        else if (order->event == MD_EVENT_ADD && feed->snapshot != NULL && feed->snapshot_orders > 0)
+        {
+            feed->snapshot_tail->next = order;
+            feed->snapshot_tail = order;
+            feed->snapshot_orders--;
+        }
+        else
+        {
+            free(order);
         }
 
-        head = head->next;
+        if (feed->snapshot != NULL && feed->snapshot_orders == 0)
+        {
+            apply_market_data_snapshot(feed, red_con);
+            free_order_list(feed->snapshot);
+            feed->snapshot = NULL;
+        }
+        order = next;
     }
+}
 
-    // Get the last quote time or set 0 if there is no active quote
-    uint64_t last_time;
-    if (order != NULL)
+void recover_market_data_gap(md_feed_t *feed, uint64_t sequence, redisContext *red_con)
+{
+    /* Helper function to request the messages from the expected sequence number up to `sequence` and to apply them.
+       Messages which are no longer kept by the exchange can't be recovered, the book is rebuilt from the snapshots. */
+    static char response[sizeof(md_packet_header_t) + MD_MAX_RETRANSMIT * (sizeof(uint16_t) + MD_MAX_MESSAGE_LEN)];
+    printf("%s | MD | Gap of %lu messages from %lu on channel %lu\n",
+           get_human_readable_time(),
+           sequence - feed->next_sequence,
+           feed->next_sequence,
+           feed->channel);
+
+    while (feed->next_sequence < sequence)
     {
-        last_time = order->t_server;
+        // Long gap is requested in several ranges
+        md_packet_header_t request;
+        memcpy(request.session, feed->session, MD_SESSION_LEN);
+        request.sequence = bswap_64(feed->next_sequence);
+        request.count = bswap_16(sequence - feed->next_sequence < MD_MAX_RETRANSMIT ? sequence - feed->next_sequence : MD_MAX_RETRANSMIT);
+
+        uint64_t length = 0;
+        if (request_market_data_retransmission(feed->addr_rewind, &request, response, &length) != 0)
+        {
+            break;
+        }
+
+        // Exchange sends only messages of its current session, which it still keeps
+        md_packet_header_t *header = (md_packet_header_t *)response;
+        uint64_t first = bswap_64(header->sequence);
+        uint64_t count = bswap_16(header->count);
+        if (memcmp(header->session, feed->session, MD_SESSION_LEN) != 0 || count == 0 || first < feed->next_sequence)
+        {
+            break;
+        }
+        if (first > feed->next_sequence)
+        {
+            printf("%s | MD | Messages %lu-%lu are lost\n",
+                   get_human_readable_time(),
+                   feed->next_sequence,
+                   first - 1);
+            feed->next_sequence = first;
+            reset_market_data_book(feed, red_con);
+        }
+
+        // Apply the recovered messages, the ones after the gap arrive with the datagram
+        apply_market_data_messages(feed, response, length, 0, red_con);
+        feed->next_sequence = first + count;
     }
-    else
+
+    if (feed->next_sequence < sequence)
     {
-        last_time = 0;
+        printf("%s | MD | Messages %lu-%lu are lost\n",
+               get_human_readable_time(),
+               feed->next_sequence,
+               sequence - 1);
+        feed->next_sequence = sequence;
+        reset_market_data_book(feed, red_con);
     }
+}
 
-    // Delete quotes which are gone
-    if (delete_inactive_quotes_from_redis(red_con, last_time) < 0)
+void apply_market_data_messages(md_feed_t *feed, char *packet, uint64_t length, uint64_t skip, redisContext *red_con)
+{
+    /* Helper function to keep the messages of the datagram for the snapshots and to apply them. First `skip` messages
+       were already applied. */
+    md_packet_header_t *header = (md_packet_header_t *)packet;
+    uint64_t sequence = bswap_64(header->sequence);
+    uint64_t count = bswap_16(header->count);
+    uint64_t offset = sizeof(md_packet_header_t);
+    for (uint64_t i = 0; i < count; i++)
     {
-        perror("Error: Cannot delete obsolte quotes: ");
-        exit(9);
+        // Each message is prefixed with its length
+        uint16_t message_length = 0;
+        if (offset + sizeof(message_length) <= length)
+        {
+            memcpy(&message_length, packet + offset, sizeof(message_length));
+            message_length = bswap_16(message_length);
+            offset += sizeof(message_length);
+        }
+        if (message_length == 0 || message_length > MD_MAX_MESSAGE_LEN || offset + message_length > length)
+        {
+            printf("%s | MD | Market data datagram is corrupted\n", get_human_readable_time());
+            break;
+        }
+        char *message = packet + offset;
+        offset += message_length;
+        if (i < skip)
+        {
+            continue;
+        }
+
+        // Snapshot may be taken before the message, then it is applied again on top of the snapshot
+        uint64_t slot = (sequence + i) & (MD_REPLAY_RING_SIZE - 1);
+        feed->lengths[slot] = message_length;
+        memcpy(feed->messages[slot], message, message_length);
+
+        apply_market_data_message(feed, message, message_length, NULL, red_con);
+    }
+}
+
+void apply_market_data_message(md_feed_t *feed, char *message, uint64_t length, char *only_symbol, redisContext *red_con)
+{
+    /* Helper function to apply the message to the book in Redis, if the book of its symbol is synced from the snapshot.
+       Fill and cancel don't carry the symbol, it is taken from the order. */
+    order_t *order = get_order_from_market_data_message(message, length);
+    if (order == NULL || order->event == MD_EVENT_SNAPSHOT)
+    {
+        free(order);
+        return;
+    }
+
+    order_t details;
+    memset(&details, 0, sizeof(details));
+    char *symbol = order->symbol;
+    if (order->event != MD_EVENT_ADD)
+    {
+        if (get_order_details_from_redis(red_con, &details, order->oid) != 0)
+        {
+            free(order);
+            return;
+        }
+        symbol = details.symbol;
+    }
+
+    if ((only_symbol == NULL || strncmp(symbol, only_symbol, sizeof(order->symbol) - 1) == 0) &&
+        find_md_symbol(feed->synced, feed->symbols, symbol) != NULL &&
+        apply_market_data_event_redis(red_con, order) < 0)
+    {
+        perror("Error: Cannot update quotes: ");
+        exit(8);
+    }
+    free(order);
+}
+
+void apply_market_data_snapshot(md_feed_t *feed, redisContext *red_con)
+{
+    /* Helper function to add the orders of the collected snapshot to the book in Redis and to apply the messages,
+       which were received after the snapshot was taken. The snapshot is skipped, if the symbol is synced already
+       or the customer isn't interested in it. If its messages aren't received yet or aren't kept any more, the symbol
+       is taken from the next cycle. */
+    order_t *snapshot = feed->snapshot;
+    uint64_t oldest = feed->next_sequence > MD_REPLAY_RING_SIZE ? feed->next_sequence - MD_REPLAY_RING_SIZE : 0;
+    if (oldest < feed->replay_sequence)
+    {
+        oldest = feed->replay_sequence;
+    }
+    if (find_md_symbol(feed->synced, feed->symbols, snapshot->symbol) != NULL || feed->symbols == MD_MAX_SYMBOLS ||
+        (feed->subscriptions > 0 && find_md_symbol(feed->subscribed, feed->subscriptions, snapshot->symbol) == NULL) ||
+        snapshot->sequence > feed->next_sequence || snapshot->sequence < oldest)
+    {
+        return;
+    }
+
+    for (order_t *head = snapshot->next; head != NULL; head = head->next)
+    {
+        if (apply_market_data_event_redis(red_con, head) < 0)
+        {
+            perror("Error: Cannot update quotes: ");
+            exit(8);
+        }
     }
 
-    // Clean memory for new message
-    free_order_list(order);
+    md_symbol_t *symbol = &feed->synced[feed->symbols++];
+    memset(symbol->symbol, '\0', sizeof(symbol->symbol));
+    strncpy(symbol->symbol, snapshot->symbol, sizeof(symbol->symbol) - 1);
+    symbol->sequence = snapshot->sequence;
+
+    // Messages of the symbol after the snapshot are applied on top of it
+    for (uint64_t sequence = snapshot->sequence; sequence < feed->next_sequence; sequence++)
+    {
+        uint64_t slot = sequence & (MD_REPLAY_RING_SIZE - 1);
+        apply_market_data_message(feed, feed->messages[slot], feed->lengths[slot], symbol->symbol, red_con);
+    }
+    printf("%s | MD | Book of %s is synced at %lu with %lu orders and %lu messages after it\n",
+           get_human_readable_time(),
+           symbol->symbol,
+           symbol->sequence,
+           snapshot->quantity,
+           feed->next_sequence - snapshot->sequence);
+}
+
+void reset_market_data_book(md_feed_t *feed, redisContext *red_con)
+{
+    /* Helper function to forget the book of the channel, when it can't be kept up to date by the messages. Books of
+       all symbols of the channel are rebuilt from the snapshots and the messages received from now on, books of other
+       channels are kept. */
+    if (delete_symbol_orders_from_redis(red_con, feed->synced, feed->symbols) < 0)
+    {
+        perror("Error: Cannot update quotes: ");
+        exit(8);
+    }
+    feed->symbols = 0;
+    feed->replay_sequence = feed->next_sequence;
+    printf("%s | MD | Book of channel %lu is rebuilt from snapshots from %lu\n",
+           get_human_readable_time(),
+           feed->channel,
+           feed->next_sequence);
 }
\ No newline at end of file
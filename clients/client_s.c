@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <arpa/inet.h>
+#include <unistd.h>
 
 // Local code
 #include "helper.h"
@@ -24,19 +25,46 @@ int main(int argc, char *argv[])
     char *client_id = calloc(1, 37 * sizeof(char));
     get_or_create_uuid(client_id);
 
+    // Open the session to exchange
+    int64_t sd = connect_to_exchange(server);
+    if (sd < 0)
+    {
+        printf("Error while connecting to exchange\n");
+        free(client_id);
+        free(order);
+        free(server);
+        return 1;
+    }
+
     // Print notification
-    if (send_order(client_id, order, server) == 0)
+    if (send_order(sd, client_id, order) == 0 && receive_order_ack(sd, order) == 0)
     {
         printf("Order sent successfully\n");
 
         // Update Redis
         server_t *addr_redis = get_server("REDIS_IP", "REDIS_PORT", IPPROTO_TCP);
         redisContext *red_con = redisConnect(addr_redis->ip, addr_redis->port);
-        if (add_order_to_redis(red_con, order, 1) < 0)
+
+        // Cancelled or replaced order is not own active order anymore, replacement takes its symbol and side
+        if (order->operation == 2 || order->operation == 3)
+        {
+            uint64_t oid = order->oid;
+            order->oid = order->target_oid;
+            process_completed_order_redis(red_con, order);
+            if (order->operation == 3)
+            {
+                get_order_details_from_redis(red_con, order, order->target_oid);
+            }
+            order->oid = oid;
+        }
+
+        // New and replacing orders are own active orders
+        if (order->operation != 2 && add_order_to_redis(red_con, order, 1) < 0)
         {
             perror("Error: Cannot add the order to Redis: ");
         }
         redisFree(red_con);
+        free(addr_redis);
     }
     else
     {
@@ -44,6 +72,7 @@ int main(int argc, char *argv[])
     }
 
     // Clean up
+    close(sd);
     free(client_id);
     free(order);
     free(server);
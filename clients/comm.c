@@ -7,39 +7,63 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <time.h>
+#include <byteswap.h>
 
 // Local code
 #include "comm.h"
 #include "helper.h"
 
+// Define aux functions
+static uint64_t recv_all(int64_t sd, char *buffer, uint64_t length)
+{
+    /* Helper function to receive exactly `length` bytes, as TCP may deliver the frame in parts */
+    uint64_t received = 0;
+    while (received < length)
+    {
+        int64_t n = recv(sd, buffer + received, length - received, 0);
+        if (n <= 0)
+        {
+            return 1;
+        }
+        received += n;
+    }
+
+    // Success
+    return 0;
+}
+
+static uint64_t send_frame(int64_t sd, void *payload, uint64_t length)
+{
+    /* Helper function to send the message with 2 bytes length in network byte order in front of it */
+    char frame[ORDER_FRAME_HEADER_LEN + MAX_MSG_LEN];
+    uint16_t frame_length = htons(length);
+    memcpy(frame, &frame_length, ORDER_FRAME_HEADER_LEN);
+    memcpy(frame + ORDER_FRAME_HEADER_LEN, payload, length);
+
+    if (send(sd, frame, ORDER_FRAME_HEADER_LEN + length, 0) < 0)
+    {
+        perror("Error: Cannot send the message: ");
+        return 4;
+    }
+
+    // Success
+    return 0;
+}
+
 // Define function prototypes
-uint64_t send_order(char *client_id, order_t *order, server_t *server)
+int64_t connect_to_exchange(server_t *server)
 {
-    // Serialize order before sending
-    char *str_order = malloc(MAX_MSG_LEN * sizeof(char));
-    sprintf(
-        str_order, "%s:%lu:%lu:%s:%lu:%.2f",
-        client_id,
-        order->t_client,
-        order->operation,
-        order->symbol,
-        order->quantity,
-        order->price);
+    /* Function to open the session to exchange, which is used for all orders of the client */
 
     // Initialize socket
     int64_t sd = socket(AF_INET, SOCK_STREAM, server->protocol);
     if (sd < 0)
     {
         perror("Error: Cannot create socket: ");
-        return 1;
+        return -1;
     }
     printf("%s: Socket created successfully\n", get_human_readable_time());
 
-    // Initialize message buffer
-    char server_message[MAX_MSG_LEN], client_message[MAX_MSG_LEN];
-    memset(server_message, '\0', sizeof(server_message));
-    memset(client_message, '\0', sizeof(client_message));
-
     // Initialize server address (Destination IP and port)
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
@@ -48,65 +72,356 @@ uint64_t send_order(char *client_id, order_t *order, server_t *server)
     if (inet_pton(AF_INET, server->ip, &server_addr.sin_addr) < 0)
     {
         perror("Error: Uncompatible IP Address: ");
-        return 2;
+        close(sd);
+        return -2;
     }
 
     // Connect to server
     if (connect(sd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
     {
         perror("Error: Cannot connect to exchange: ");
-        return 3;
+        close(sd);
+        return -3;
     }
 
+    return sd;
+}
+
+uint64_t send_order(int64_t sd, char *client_id, order_t *order)
+{
+    /* Function to send the order in the open session. Orders can be pipelined,
+       acknowledgements are read afterwards with `receive_order_ack()` in the same order. */
+
+    // Serialize order before sending after the frame header, cancel and replace refer to the order by its id
+    char frame[ORDER_FRAME_HEADER_LEN + MAX_MSG_LEN];
+    int64_t n = 0;
+    if (order->operation == 2)
+    {
+        n = snprintf(
+            frame + ORDER_FRAME_HEADER_LEN, MAX_MSG_LEN, "%s:%lu:%lu:%lu",
+            client_id,
+            order->t_client,
+            order->operation,
+            order->target_oid);
+    }
+    else if (order->operation == 3)
+    {
+        n = snprintf(
+            frame + ORDER_FRAME_HEADER_LEN, MAX_MSG_LEN, "%s:%lu:%lu:%lu:%lu:%lu.%02lu",
+            client_id,
+            order->t_client,
+            order->operation,
+            order->target_oid,
+            order->quantity,
+            order->price / PRICE_SCALE,
+            order->price % PRICE_SCALE);
+    }
+    else
+    {
+        n = snprintf(
+            frame + ORDER_FRAME_HEADER_LEN, MAX_MSG_LEN, "%s:%lu:%lu:%s:%lu:%lu.%02lu",
+            client_id,
+            order->t_client,
+            order->operation,
+            order->symbol,
+            order->quantity,
+            order->price / PRICE_SCALE,
+            order->price % PRICE_SCALE);
+    }
+    if (n < 0 || n >= MAX_MSG_LEN)
+    {
+        printf("%s: Order is too long to be sent\n", get_human_readable_time());
+        return 1;
+    }
+    uint16_t frame_length = htons(n);
+    memcpy(frame, &frame_length, ORDER_FRAME_HEADER_LEN);
+
     // Send order to exchange
-    if (send(sd, str_order, strlen(str_order), 0) < 0)
+    if (send(sd, frame, ORDER_FRAME_HEADER_LEN + n, 0) < 0)
     {
         perror("Error: Cannot send the message: ");
         return 4;
     }
-    printf("%s: Order sent to exchange, waiting for response...\n", get_human_readable_time());
+    printf("%s: Order sent to exchange\n", get_human_readable_time());
+
+    // Return success if everything is OK
+    return 0;
+}
+
+uint64_t receive_order_ack(int64_t sd, order_t *order)
+{
+    /* Function to read the acknowledgement of the next order sent in the session */
 
     // Receive exchange's response
-    if (recv(sd, server_message, sizeof(server_message), 0) < 0)
+    char server_message[MAX_MSG_LEN];
+    uint16_t frame_length;
+    if (recv_all(sd, (char *)&frame_length, ORDER_FRAME_HEADER_LEN) != 0)
     {
         perror("Error: Cannot receive the message: ");
         return 5;
     }
+    uint64_t n = ntohs(frame_length);
+    if (n >= MAX_MSG_LEN || recv_all(sd, server_message, n) != 0)
+    {
+        perror("Error: Cannot receive the message: ");
+        return 5;
+    }
+    server_message[n] = '\0';
     printf("%s: Exchange's response: %s\n", get_human_readable_time(), server_message);
 
     // Analyze exchange's response
-    uint64_t n = strlen(server_message);
-    char *read_buffer = calloc(1, n * sizeof(char));
+    char *delimiter = strchr(server_message, ':');
+    if (delimiter == NULL)
+    {
+        printf("%s: Error while analyzing exchange's response\n", get_human_readable_time());
+        return 14;
+    }
+    order->t_server = strtoul(server_message, NULL, 10);
+    order->oid = strtoul(delimiter + 1, NULL, 10);
+
+    // Return success if everything is OK
+    return 0;
+}
+
+uint64_t send_logon(int64_t sd, char *client_id)
+{
+    /* Function to bind the session to the customer. It must be sent before the binary orders. */
+    order_entry_logon_message_t message;
+    message.type = ORDER_ENTRY_LOGON;
+    memcpy(message.cid, client_id, sizeof(message.cid));
+
+    return send_frame(sd, &message, sizeof(message));
+}
 
-    for (uint64_t i = 0; i < n; i++)
+uint64_t send_order_binary(int64_t sd, order_t *order)
+{
+    /* Function to send the order, cancel or replace in the binary format with fixed offsets and price in ticks.
+       Acknowledgements are read afterwards with `receive_order_ack_binary()` in the same order. */
+    if (order->operation == 2)
     {
-        // If delimeter is found, convert to digits what is so far parsed
-        if (server_message[i] == ':')
-        {
-            order->t_server = strtol(read_buffer, NULL, 10);
+        order_entry_cancel_message_t message;
+        message.type = ORDER_ENTRY_CANCEL;
+        message.t_client = bswap_64(order->t_client);
+        message.order_id = bswap_64(order->target_oid);
+
+        return send_frame(sd, &message, sizeof(message));
+    }
+    else if (order->operation == 3)
+    {
+        order_entry_replace_message_t message;
+        message.type = ORDER_ENTRY_REPLACE;
+        message.t_client = bswap_64(order->t_client);
+        message.order_id = bswap_64(order->target_oid);
+        message.quantity = bswap_64(order->quantity);
+        message.price = bswap_64(order->price);
+
+        return send_frame(sd, &message, sizeof(message));
+    }
+
+    order_entry_order_message_t message;
+    memset(&message, 0, sizeof(message));
+    message.type = ORDER_ENTRY_ORDER;
+    message.t_client = bswap_64(order->t_client);
+    message.operation = order->operation;
+    strncpy(message.symbol, order->symbol, sizeof(message.symbol));
+    message.quantity = bswap_64(order->quantity);
+    message.price = bswap_64(order->price);
+
+    return send_frame(sd, &message, sizeof(message));
+}
+
+uint64_t receive_order_ack_binary(int64_t sd, order_t *order)
+{
+    /* Function to read the binary acknowledgement of the next order sent in the session */
+    uint16_t frame_length;
+    order_entry_ack_message_t message;
+    if (recv_all(sd, (char *)&frame_length, ORDER_FRAME_HEADER_LEN) != 0 ||
+        ntohs(frame_length) != sizeof(message) ||
+        recv_all(sd, (char *)&message, sizeof(message)) != 0 ||
+        message.type != ORDER_ENTRY_ACK)
+    {
+        printf("%s: Error while analyzing exchange's response\n", get_human_readable_time());
+        return 14;
+    }
+
+    // Analyze exchange's response
+    order->t_server = bswap_64(message.ts_ack);
+    order->oid = bswap_64(message.order_id);
 
-            // free the buffer and re-allocate it again
-            free(read_buffer);
-            read_buffer = calloc(1, n * sizeof(char));
+    // Return success if everything is OK
+    return 0;
+}
+
+uint64_t request_market_data_retransmission(server_t *server, md_packet_header_t *request, char *response, uint64_t *length)
+{
+    /* Function to request the range of lost market data messages. The response has the layout of the datagram,
+       so it is decoded the same way, `length` is set to its size. */
+    int64_t sd = connect_to_exchange(server);
+    if (sd < 0)
+    {
+        return 1;
+    }
+
+    if (send(sd, request, sizeof(md_packet_header_t), 0) < 0)
+    {
+        perror("Error: Cannot send retransmission request: ");
+        close(sd);
+        return 2;
+    }
+
+    // Header tells how many messages follow, each is prefixed with its length
+    md_packet_header_t *header = (md_packet_header_t *)response;
+    if (recv_all(sd, response, sizeof(md_packet_header_t)) != 0 || bswap_16(header->count) > MD_MAX_RETRANSMIT)
+    {
+        printf("%s: Unable to receive retransmission response\n", get_human_readable_time());
+        close(sd);
+        return 3;
+    }
+    uint64_t offset = sizeof(md_packet_header_t);
+    for (uint64_t i = 0; i < bswap_16(header->count); i++)
+    {
+        uint16_t message_length;
+        if (recv_all(sd, response + offset, sizeof(message_length)) != 0)
+        {
+            printf("%s: Unable to receive retransmission response\n", get_human_readable_time());
+            close(sd);
+            return 3;
         }
-        else
+        memcpy(&message_length, response + offset, sizeof(message_length));
+        offset += sizeof(message_length);
+        if (bswap_16(message_length) > MD_MAX_MESSAGE_LEN || recv_all(sd, response + offset, bswap_16(message_length)) != 0)
         {
-            strncat(read_buffer, &server_message[i], 1);
+            printf("%s: Unable to receive retransmission response\n", get_human_readable_time());
+            close(sd);
+            return 3;
         }
+        offset += bswap_16(message_length);
     }
-    order->oid = strtol(read_buffer, NULL, 10);
+    *length = offset;
 
-    if (order->t_server == 3833738885019939885 || order->oid == 1688241182)
+    close(sd);
+
+    // Success
+    return 0;
+}
+
+uint64_t request_market_data_directory(server_t *server, md_symbol_t *symbols, uint64_t count, char *response, uint64_t *length)
+{
+    /* Function to ask the directory of market data, which channels the symbols are sent on. The response is the header,
+       the addresses of all channels and the channel of each symbol, `length` is set to its size. */
+    int64_t sd = connect_to_exchange(server);
+    if (sd < 0)
     {
-        printf("%s: Error while analyzing exchange's response\n", get_human_readable_time());
-        return 14;
+        return 1;
+    }
+
+    // Symbols follow the number of them, each is padded to the fixed length
+    char request[sizeof(md_directory_request_t) + MD_MAX_SUBSCRIPTIONS * sizeof(symbols->symbol)];
+    md_directory_request_t *header = (md_directory_request_t *)request;
+    header->count = bswap_16(count);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        memcpy(request + sizeof(md_directory_request_t) + i * sizeof(symbols->symbol), symbols[i].symbol, sizeof(symbols->symbol));
+    }
+    if (send(sd, request, sizeof(md_directory_request_t) + count * sizeof(symbols->symbol), 0) < 0)
+    {
+        perror("Error: Cannot send directory request: ");
+        close(sd);
+        return 2;
+    }
+
+    // Header tells how many channels and symbols follow
+    md_directory_header_t *directory = (md_directory_header_t *)response;
+    if (recv_all(sd, response, sizeof(md_directory_header_t)) != 0 ||
+        bswap_16(directory->channels) > MD_MAX_CHANNELS || bswap_16(directory->count) != count)
+    {
+        printf("%s: Unable to receive directory response\n", get_human_readable_time());
+        close(sd);
+        return 3;
+    }
+    *length = sizeof(md_directory_header_t) +
+              bswap_16(directory->channels) * sizeof(md_directory_channel_t) +
+              count * sizeof(md_directory_symbol_t);
+    if (recv_all(sd, response + sizeof(md_directory_header_t), *length - sizeof(md_directory_header_t)) != 0)
+    {
+        printf("%s: Unable to receive directory response\n", get_human_readable_time());
+        close(sd);
+        return 3;
     }
 
-    // Clean up
-    free(read_buffer);
-    free(str_order);
     close(sd);
 
-    // Return success if everything is OK
+    // Success
     return 0;
+}
+
+int64_t join_market_data_group(server_t *group, server_t *local)
+{
+    /* Function to open the socket, which receives the market data channel of the multicast group on the local interface */
+
+    // Initialize socket
+    int64_t sd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sd < 0)
+    {
+        perror("Error: UDP: Cannot create socket: ");
+        return -1;
+    }
+
+    // Initialize server listen address (MCAST Group)
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(group->port);
+    if (inet_pton(server_addr.sin_family, group->ip, &server_addr.sin_addr) < 0)
+    {
+        perror("Error: UDP: Uncompatible IP Address: ");
+        close(sd);
+        return -2;
+    }
+
+    // Allow reuse of same port as it can be used in different MCAST Groups
+    uint64_t so_reuseaddr = 1;
+    if (setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &so_reuseaddr, sizeof(so_reuseaddr)) < 0)
+    {
+        perror("Error: UDP: Cannot set socket option: ");
+        close(sd);
+        return -3;
+    }
+
+    // Bind socket
+    if (bind(sd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        perror("Error: UDP: Cannot bind socket: ");
+        close(sd);
+        return -4;
+    }
+
+    // Initialize request to join multicast (somehow <linux/in.h> doesn't work for me)
+    struct ip_mreq
+    {
+        /* IP multicast address of group.  */
+        struct in_addr imr_multiaddr;
+
+        /* Local IP address of interface.  */
+        struct in_addr imr_interface;
+    };
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    if (inet_pton(server_addr.sin_family, group->ip, &mreq.imr_multiaddr) < 0 ||
+        inet_pton(server_addr.sin_family, local->ip, &mreq.imr_interface) < 0)
+    {
+        perror("Error: UDP: Uncompatible IP Address: ");
+        close(sd);
+        return -2;
+    }
+
+    // Join multicast group
+    if (setsockopt(sd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+    {
+        perror("Error: Cannot join multicast group: ");
+        close(sd);
+        return -5;
+    }
+
+    return sd;
 }
\ No newline at end of file
@@ -8,4 +8,12 @@
 #define MAX_MSG_LEN 1024
 
 // Decalre function prototypes
-uint64_t send_order(char *client_id, order_t *order, server_t *server);
\ No newline at end of file
+int64_t connect_to_exchange(server_t *server);
+uint64_t send_order(int64_t sd, char *client_id, order_t *order);
+uint64_t receive_order_ack(int64_t sd, order_t *order);
+uint64_t send_logon(int64_t sd, char *client_id);
+uint64_t send_order_binary(int64_t sd, order_t *order);
+uint64_t receive_order_ack_binary(int64_t sd, order_t *order);
+uint64_t request_market_data_retransmission(server_t *server, md_packet_header_t *request, char *response, uint64_t *length);
+uint64_t request_market_data_directory(server_t *server, md_symbol_t *symbols, uint64_t count, char *response, uint64_t *length);
+int64_t join_market_data_group(server_t *group, server_t *local);
\ No newline at end of file
@@ -47,6 +47,7 @@ uint64_t get_operation(char *op)
         - 0 for sell opeation
         - 1 for buy operation
         - 2 for cancel operation
+        - 3 for replace operation
     */
     if (memcmp(op, "buy", 3) == 0)
     {
@@ -60,6 +61,10 @@ uint64_t get_operation(char *op)
     {
         return 2;
     }
+    else if (memcmp(op, "replace", 7) == 0)
+    {
+        return 3;
+    }
     else
     {
         return 9999;
@@ -97,12 +102,127 @@ server_t *get_server(char *env_ip, char *env_port, uint64_t protocol)
     return server;
 }
 
-order_t *get_orders_from_tape(char *tape)
+price_t parse_price(char *str)
 {
-    /* Helper function to parse tape */
-    uint64_t msg_len = strlen(tape);
-    uint64_t msg_pos = 0;
-    uint64_t t_server = 0;
+    /* Helper function to convert decimal price text (e.g., `10.03`) to integer number of ticks.
+       Digits beyond the tick size are truncated, no floating point conversion is involved. */
+    price_t units = 0;
+    price_t fraction = 0;
+    uint64_t scale = PRICE_SCALE;
+
+    // Integer part
+    uint64_t i = 0;
+    while (str[i] >= '0' && str[i] <= '9')
+    {
+        units = units * 10 + (str[i] - '0');
+        i++;
+    }
+
+    // Fractional part
+    if (str[i] == '.')
+    {
+        i++;
+        while (str[i] >= '0' && str[i] <= '9' && scale > 1)
+        {
+            scale /= 10;
+            fraction += (str[i] - '0') * scale;
+            i++;
+        }
+    }
+
+    return units * PRICE_SCALE + fraction;
+}
+
+uint64_t get_subscribed_symbols(md_symbol_t *symbols)
+{
+    /* Helper function to get the comma separated symbols, which the customer is interested in, from `CUSTOMER_SYMBOLS`.
+       Returns the number of symbols, zero means all symbols. */
+    char *env = getenv("CUSTOMER_SYMBOLS");
+    if (env == NULL)
+    {
+        return 0;
+    }
+
+    char *list = strdup(env);
+    char *saveptr = NULL;
+    uint64_t count = 0;
+    for (char *token = strtok_r(list, ",", &saveptr); token != NULL; token = strtok_r(NULL, ",", &saveptr))
+    {
+        if (count == MD_MAX_SUBSCRIPTIONS || strlen(token) >= sizeof(symbols->symbol))
+        {
+            printf("%s: Symbol '%s' is skipped\n", get_human_readable_time(), token);
+            continue;
+        }
+        memset(symbols[count].symbol, '\0', sizeof(symbols[count].symbol));
+        strncpy(symbols[count].symbol, token, sizeof(symbols[count].symbol) - 1);
+        symbols[count].sequence = 0;
+        count++;
+    }
+    free(list);
+
+    return count;
+}
+
+md_symbol_t *find_md_symbol(md_symbol_t *symbols, uint64_t count, char *symbol)
+{
+    /* Helper function to find the symbol in the list. Returns `NULL` if it isn't there. */
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (strncmp(symbols[i].symbol, symbol, sizeof(symbols[i].symbol) - 1) == 0)
+        {
+            return &symbols[i];
+        }
+    }
+
+    return NULL;
+}
+
+order_t *get_order_from_market_data_message(char *message, uint64_t length)
+{
+    /* Helper function to decode the market data message in place through the structs of the protocol.
+       Returns `NULL` for messages, which don't change the book (e.g., system events) and for unknown ones. */
+
+    // System events don't change the book
+    if (message[0] == MD_EVENT_SYSTEM && length >= sizeof(md_system_event_message_t))
+    {
+        md_system_event_message_t *system_event = (md_system_event_message_t *)message;
+        printf("%s: Market data system event '%c'\n", get_human_readable_time(), system_event->event_code);
+        return NULL;
+    }
+
+    // Quotes of the QBBO channel are only printed, the book is kept by the deltas
+    if (message[0] == MD_EVENT_QUOTE && length >= sizeof(md_quote_message_t))
+    {
+        md_quote_message_t *quote = (md_quote_message_t *)message;
+        uint64_t bid_price = bswap_64(quote->bid_price);
+        uint64_t ask_price = bswap_64(quote->ask_price);
+        printf("%s: Quote %.10s %lu @ %lu.%02lu / %lu @ %lu.%02lu\n",
+               get_human_readable_time(),
+               quote->stock,
+               bswap_64(quote->bid_size),
+               bid_price / PRICE_SCALE,
+               bid_price % PRICE_SCALE,
+               bswap_64(quote->ask_size),
+               ask_price / PRICE_SCALE,
+               ask_price % PRICE_SCALE);
+        return NULL;
+    }
+
+    // Trades of the Last Sale channel are only printed, the fills are also sent as executions in the deltas
+    if (message[0] == MD_EVENT_TRADE && length >= sizeof(md_trade_message_t))
+    {
+        md_trade_message_t *trade = (md_trade_message_t *)message;
+        uint64_t price = bswap_64(trade->price);
+        printf("%s: Trade %.10s %c %lu @ %lu.%02lu, match %lu\n",
+               get_human_readable_time(),
+               trade->stock,
+               trade->side,
+               bswap_64(trade->shares),
+               price / PRICE_SCALE,
+               price % PRICE_SCALE,
+               bswap_64(trade->match_number));
+        return NULL;
+    }
 
     // Allocate memory for order and initialize values to 0/NULL
     order_t *order = calloc(1, sizeof(order_t));
@@ -111,78 +231,106 @@ order_t *get_orders_from_tape(char *tape)
         printf("%s: Unable to allocate memory for order\n", get_human_readable_time());
         return NULL;
     }
-    order->next = NULL;
+    order->event = message[0];
 
-    // Allocate buffer
-    char buffer[100];
-    memset(buffer, '\0', sizeof(buffer));
+    if (message[0] == MD_EVENT_ADD && length >= sizeof(md_add_order_message_t))
+    {
+        md_add_order_message_t *add_order = (md_add_order_message_t *)message;
+        order->t_server = bswap_64(add_order->timestamp);
+        order->oid = bswap_64(add_order->order_id);
+        order->operation = add_order->side == MD_SIDE_BUY ? 1 : 0;
+        order->quantity = bswap_64(add_order->shares);
+        memcpy(order->symbol, add_order->stock, sizeof(order->symbol) - 1);
+        order->price = bswap_64(add_order->price);
+    }
+    else if (message[0] == MD_EVENT_EXECUTE && length >= sizeof(md_order_executed_message_t))
+    {
+        md_order_executed_message_t *order_executed = (md_order_executed_message_t *)message;
+        order->t_server = bswap_64(order_executed->timestamp);
+        order->oid = bswap_64(order_executed->order_id);
+        order->quantity = bswap_64(order_executed->executed_shares);
+    }
+    else if (message[0] == MD_EVENT_CANCEL && length >= sizeof(md_order_cancel_message_t))
+    {
+        md_order_cancel_message_t *order_cancel = (md_order_cancel_message_t *)message;
+        order->t_server = bswap_64(order_cancel->timestamp);
+        order->oid = bswap_64(order_cancel->order_id);
+        order->quantity = bswap_64(order_cancel->cancelled_shares);
+    }
+    // Snapshot of the symbol, quantity is the number of orders in it
+    else if (message[0] == MD_EVENT_SNAPSHOT && length >= sizeof(md_snapshot_message_t))
+    {
+        md_snapshot_message_t *snapshot = (md_snapshot_message_t *)message;
+        order->t_server = bswap_64(snapshot->timestamp);
+        memcpy(order->symbol, snapshot->stock, sizeof(order->symbol) - 1);
+        order->sequence = bswap_64(snapshot->sequence);
+        order->quantity = bswap_64(snapshot->orders);
+    }
+    // Unknown messages are skipped, so that new message types don't break the client
+    else
+    {
+        free(order);
+        return NULL;
+    }
 
-    // Set moving head
-    order_t *head = order;
+    return order;
+}
+
+order_t *get_orders_from_market_data(char *packet, uint64_t length, uint64_t skip)
+{
+    /* Helper function to decode the market data datagram, events are returned in the order they have to be applied.
+       First `skip` messages were already applied (e.g., recovered by retransmission), so they are passed over. */
+    if (length < sizeof(md_packet_header_t))
+    {
+        printf("%s: Market data datagram is too short\n", get_human_readable_time());
+        return NULL;
+    }
+    md_packet_header_t *header = (md_packet_header_t *)packet;
+    uint64_t count = bswap_16(header->count);
+    uint64_t offset = sizeof(md_packet_header_t);
 
-    // Loop through all characters in the tape
-    for (uint64_t i = 0; i < msg_len; i++)
+    order_t *head = NULL;
+    order_t *tail = NULL;
+    for (uint64_t i = 0; i < count; i++)
     {
-        // Replace '/' with ' ' to split the string
-        if (tape[i] == '/')
+        // Each message is prefixed with its length
+        uint16_t message_length = 0;
+        if (offset + sizeof(message_length) <= length)
         {
-            tape[i] = ' ';
+            memcpy(&message_length, packet + offset, sizeof(message_length));
+            message_length = bswap_16(message_length);
+            offset += sizeof(message_length);
+        }
+        if (message_length == 0 || offset + message_length > length)
+        {
+            printf("%s: Market data datagram is corrupted\n", get_human_readable_time());
+            break;
+        }
+        char *message = packet + offset;
+        offset += message_length;
+        if (i < skip)
+        {
+            continue;
         }
 
-        // Find boundaries
-        if (tape[i] != ':')
+        order_t *order = get_order_from_market_data_message(message, message_length);
+        if (order == NULL)
         {
-            strncat(buffer, &tape[i], 1);
+            continue;
+        }
+
+        // Keep events in the order of the datagram
+        if (tail == NULL)
+        {
+            head = order;
         }
         else
         {
-            // Pickup the timestamp
-            if (msg_pos == 1)
-            {
-                t_server = strtoul(buffer, NULL, 10);
-            }
-            // Pick up values
-            if (msg_pos > 1)
-            {
-                // replace '/' with ' ' to split the string
-                for (uint64_t j = 0; j < strlen(buffer); j++)
-                {
-                    if (buffer[j] == '/')
-                    {
-                        buffer[j] = ' ';
-                    }
-                }
-
-                sscanf(buffer, "%lu %s %lu %f %lu", &head->oid, head->symbol, &head->operation, &head->price, &head->quantity);
-
-                // Set timestamp
-                head->t_server = t_server;
-
-                // Create new order and update the head
-                order_t *new_order = malloc(sizeof(order_t));
-                if (new_order == NULL)
-                {
-                    perror("Error: Cannot allocate memory: ");
-                    free_order_list(head);
-                    return NULL;
-                }
-                memset(new_order->symbol, '\0', sizeof(new_order->symbol));
-                new_order->next = head;
-                head = new_order;
-            }
-            // printf("%s\n", buffer);
-            memset(buffer, '\0', sizeof(buffer));
-
-            // Update counter
-            msg_pos++;
+            tail->next = order;
         }
+        tail = order;
     }
 
-    // Free memory for the last order
-    order_t *temp = head;
-    head = head->next;
-    free(temp);
-
     return head;
 }
 
@@ -205,7 +353,7 @@ int64_t add_order_to_redis(redisContext *red_con, order_t *order, uint64_t my_or
     /* Helper function to add active order to redis*/
 
     // Create Hash with order details
-    redisReply *red_rep1 = redisCommand(red_con, "HSET %s:%lu oid %lu t_server %lu symbol %s op %lu price %.2f qty %lu",
+    redisReply *red_rep1 = redisCommand(red_con, "HSET %s:%lu oid %lu t_server %lu symbol %s op %lu price %lu qty %lu",
                                         REDIS_CUSTOMER_ORDER_PREFIX,
                                         order->oid,
                                         order->oid,
@@ -275,64 +423,90 @@ int64_t add_order_to_redis(redisContext *red_con, order_t *order, uint64_t my_or
     return 0;
 }
 
-int64_t delete_inactive_quotes_from_redis(redisContext *red_con, uint64_t last_time)
+int64_t apply_market_data_event_redis(redisContext *red_con, order_t *order)
 {
-    /* Helper function to remove inactive order from redis*/
+    /* Helper function to apply the change of the order in the exchange book to the orders in Redis */
 
-    // Get list of existings orders
-    redisReply *red_rep1 = redisCommand(red_con, "HGETALL %s",
-                                        REDIS_CUSTOMER_ALL_ORDERS);
-    if (red_rep1->str != NULL)
+    // New resting order
+    if (order->event == MD_EVENT_ADD)
     {
-        printf("%s: Unable to get orders' list in Redis: %s\n",
-               get_human_readable_time(),
-               red_rep1->str);
+        return add_order_to_redis(red_con, order, 0);
+    }
+
+    // Fill reduces the remaining quantity, the order is gone once it is fully filled
+    int64_t leaves = 0;
+    if (order->event == MD_EVENT_EXECUTE)
+    {
+        redisReply *red_rep1 = redisCommand(red_con, "HINCRBY %s:%lu qty -%lu",
+                                            REDIS_CUSTOMER_ORDER_PREFIX,
+                                            order->oid,
+                                            order->quantity);
+        if (red_rep1 == NULL || red_rep1->type != REDIS_REPLY_INTEGER)
+        {
+            printf("%s: Unable to update order %lu in Redis\n", get_human_readable_time(), order->oid);
+            freeReplyObject(red_rep1);
+            return -1;
+        }
+        leaves = red_rep1->integer;
         freeReplyObject(red_rep1);
+    }
+    else if (order->event != MD_EVENT_CANCEL)
+    {
+        printf("%s: Unknown market data event '%c'\n", get_human_readable_time(), order->event);
         return -1;
     }
-    else
+
+    // Delete order from list of active orders, its details are kept as before
+    if (leaves <= 0)
     {
-        printf("%s: Orders' list is collected in Redis.\n",
-               get_human_readable_time());
+        redisReply *red_rep2 = redisCommand(red_con, "HDEL %s %lu", REDIS_CUSTOMER_ALL_ORDERS, order->oid);
+        if (red_rep2 == NULL || red_rep2->type == REDIS_REPLY_ERROR)
+        {
+            printf("%s: Unable to delete order %lu from Redis\n", get_human_readable_time(), order->oid);
+            freeReplyObject(red_rep2);
+            return -1;
+        }
+        printf("%s: Order %lu is deleted in Redis.\n", get_human_readable_time(), order->oid);
+        freeReplyObject(red_rep2);
     }
 
-    // Loop through all orders
-    for (uint64_t i = 0; i < red_rep1->elements; i += 2)
+    // Success
+    return 0;
+}
+
+int64_t delete_symbol_orders_from_redis(redisContext *red_con, md_symbol_t *symbols, uint64_t count)
+{
+    /* Helper function to forget the book of the symbols, e.g. before it is rebuilt from the market data snapshots.
+       Books of other symbols are kept. */
+    redisReply *red_rep1 = redisCommand(red_con, "HKEYS %s", REDIS_CUSTOMER_ALL_ORDERS);
+    if (red_rep1 == NULL || red_rep1->type != REDIS_REPLY_ARRAY)
     {
-        // Check delete element if timestamp is less than last_time
-        if ((uint64_t)strtol(red_rep1->element[i + 1]->str, NULL, 10) != last_time)
+        printf("%s: Unable to get orders' list in Redis\n", get_human_readable_time());
+        freeReplyObject(red_rep1);
+        return -1;
+    }
+
+    for (uint64_t i = 0; i < red_rep1->elements; i++)
+    {
+        order_t order;
+        memset(&order, 0, sizeof(order));
+        order.oid = strtoul(red_rep1->element[i]->str, NULL, 10);
+        if (get_order_details_from_redis(red_con, &order, order.oid) != 0 ||
+            find_md_symbol(symbols, count, order.symbol) == NULL)
         {
-            printf("HDEL %s %s\n",
-                   REDIS_CUSTOMER_ALL_ORDERS,
-                   red_rep1->element[i]->str);
-            // Delete order from list of active orders
-            redisReply *red_rep2 = redisCommand(red_con, "HDEL %s %s",
-                                                REDIS_CUSTOMER_ALL_ORDERS,
-                                                red_rep1->element[i]->str);
-            if (red_rep2->str != NULL)
-            {
-                printf("%s: Unable to delete order fro, Redis: %s\n",
-                       get_human_readable_time(),
-                       red_rep2->str);
-                freeReplyObject(red_rep2);
-                return -1;
-            }
-            else
-            {
-                printf("%s: Order %s is deleted in Redis.\n",
-                       get_human_readable_time(),
-                       red_rep1->element[i]->str);
-            }
+            continue;
+        }
 
-            // Cleanup
+        redisReply *red_rep2 = redisCommand(red_con, "HDEL %s %lu", REDIS_CUSTOMER_ALL_ORDERS, order.oid);
+        if (red_rep2 == NULL || red_rep2->type == REDIS_REPLY_ERROR)
+        {
+            printf("%s: Unable to delete order %lu from Redis\n", get_human_readable_time(), order.oid);
             freeReplyObject(red_rep2);
-
-            // Order details will be in memory, but there is no efficient way to delete them
-            // So some sort of garbage collection will be needed
+            freeReplyObject(red_rep1);
+            return -1;
         }
+        freeReplyObject(red_rep2);
     }
-
-    // Cleanup
     freeReplyObject(red_rep1);
 
     // Success
@@ -413,10 +587,12 @@ void print_order_from_redis(uint64_t my_or_all)
                 memcpy(op_text, "BUY", 3);
             }
 
-            printf("  - symbol:          %s\n    operation:       %s\n    price per share: %s\n    quantity:        %s\n\n",
+            price_t price = strtoul(red_rep2->element[4]->str, NULL, 10);
+            printf("  - symbol:          %s\n    operation:       %s\n    price per share: %lu.%02lu\n    quantity:        %s\n\n",
                    red_rep2->element[2]->str,
                    op_text,
-                   red_rep2->element[4]->str,
+                   price / PRICE_SCALE,
+                   price % PRICE_SCALE,
                    red_rep2->element[5]->str);
         }
         freeReplyObject(red_rep2);
@@ -473,6 +649,28 @@ order_t *deserialize_exhange_confirmation(char *msg)
     return order;
 }
 
+int64_t get_order_details_from_redis(redisContext *red_con, order_t *order, uint64_t oid)
+{
+    /* Helper function to read symbol and operation of own order, which is replaced */
+    redisReply *red_rep1 = redisCommand(red_con, "HMGET %s:%lu symbol op",
+                                        REDIS_CUSTOMER_ORDER_PREFIX,
+                                        oid);
+    if (red_rep1->type != REDIS_REPLY_ARRAY || red_rep1->elements != 2 ||
+        red_rep1->element[0]->str == NULL || red_rep1->element[1]->str == NULL)
+    {
+        printf("%s: Unable to get order %lu from Redis.\n", get_human_readable_time(), oid);
+        freeReplyObject(red_rep1);
+        return -1;
+    }
+    memset(order->symbol, '\0', sizeof(order->symbol));
+    strncpy(order->symbol, red_rep1->element[0]->str, sizeof(order->symbol) - 1);
+    order->operation = strtoul(red_rep1->element[1]->str, NULL, 10);
+    freeReplyObject(red_rep1);
+
+    // Return success
+    return 0;
+}
+
 int64_t process_completed_order_redis(redisContext *red_con, order_t *order)
 {
     /* Helper function to process the order to redis */
@@ -532,9 +730,10 @@ uint64_t get_time_nanoseconds_midnight()
     /* Helper function to get time in nanoseconds at the midnight this day.
        Return `-1` in case of errors.*/
 
-    // Get current time in struct
+    // Get current time in struct, the reentrant call doesn't share the static buffer between threads
     time_t now = time(NULL);
-    struct tm now_st = *localtime(&now);
+    struct tm now_st;
+    localtime_r(&now, &now_st);
 
     // Erase hours, minutes, seconds
     now_st.tm_hour = 0;
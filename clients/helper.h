@@ -9,12 +9,18 @@
 void get_or_create_uuid(char *uuid);
 uint64_t get_operation(char *op);
 server_t *get_server(char *env_ip, char *env_port, uint64_t protocol);
-order_t *get_orders_from_tape(char *tape);
+price_t parse_price(char *str);
+uint64_t get_subscribed_symbols(md_symbol_t *symbols);
+md_symbol_t *find_md_symbol(md_symbol_t *symbols, uint64_t count, char *symbol);
+order_t *get_order_from_market_data_message(char *message, uint64_t length);
+order_t *get_orders_from_market_data(char *packet, uint64_t length, uint64_t skip);
 void free_order_list(order_t *order);
 int64_t add_order_to_redis(redisContext *red_con, order_t *order, uint64_t my_or_all);
-int64_t delete_inactive_quotes_from_redis(redisContext *red_con, uint64_t last_time);
+int64_t apply_market_data_event_redis(redisContext *red_con, order_t *order);
+int64_t delete_symbol_orders_from_redis(redisContext *red_con, md_symbol_t *symbols, uint64_t count);
 void print_order_from_redis(uint64_t my_or_all);
 order_t *deserialize_exhange_confirmation(char *msg);
+int64_t get_order_details_from_redis(redisContext *red_con, order_t *order, uint64_t oid);
 int64_t process_completed_order_redis(redisContext *red_con, order_t *order);
 order_t *deserialize_exchange_confirmation_2(struct order_gateway_request_message_t *ogm);
 char *get_human_readable_time();
@@ -9,11 +9,55 @@
 #define REDIS_CUSTOMER_MY_ORDERS "customer_my_orders"
 #define REDIS_CUSTOMER_ORDER_PREFIX "c-order"
 #define LISTENQ 10
+#define MAX_POLL_FDS 64
+
+// Order sessions data, each order is framed with 2 bytes length in network byte order
+#define ORDER_FRAME_HEADER_LEN 2
+
+// Binary order entry message types
+#define ORDER_ENTRY_LOGON 'L'
+#define ORDER_ENTRY_ORDER 'O'
+#define ORDER_ENTRY_CANCEL 'X'
+#define ORDER_ENTRY_REPLACE 'U'
+#define ORDER_ENTRY_ACK 'A'
+
+// Market data events, the feed carries changes of the resting orders in the exchange books
+#define MD_EVENT_ADD 'A'
+#define MD_EVENT_EXECUTE 'E'
+#define MD_EVENT_CANCEL 'X'
+
+// Market data protocol, ITCH-style binary messages are packed into MoldUDP64-style datagrams, which fit into the MTU
+#define MD_EVENT_SYSTEM 'S'
+#define MD_SIDE_BUY 'B'
+#define MD_SESSION_LEN 10
+#define MD_MAX_PAYLOAD 1472
+
+// Market data retransmission, lost messages are requested over TCP in ranges not longer than the maximum
+#define MD_MAX_MESSAGE_LEN 64
+#define MD_MAX_RETRANSMIT 1024
+
+// Market data snapshots, books of symbols are rebuilt from the snapshot channel and the deltas kept since it was taken
+#define MD_EVENT_SNAPSHOT 'G'
+#define MD_MAX_SYMBOLS 8192
+#define MD_REPLAY_RING_SIZE 16384
+
+// Market data channels, symbols are sharded across the channels, the directory tells the channel of each symbol
+#define MD_MAX_CHANNELS 16
+#define MD_MAX_SUBSCRIPTIONS 1024
+
+// Market data quotes, the QBBO channel carries the conflated best bid and offer of the symbols
+#define MD_EVENT_QUOTE 'Q'
+#define MD_EVENT_TRADE 'P'
+
+// Price data, prices are kept as integer number of ticks
+#define PRICE_SCALE 100
 
 // Data types
 #ifndef _MY_HEADER_H_
 #define _MY_HEADER_H_
 
+typedef uint64_t price_t;
+
 typedef struct order_t
 {
     uint64_t t_client;
@@ -22,7 +66,10 @@ typedef struct order_t
     char symbol[10];
     uint64_t operation;
     uint64_t quantity;
-    float price;
+    price_t price;
+    uint64_t target_oid;
+    char event;
+    uint64_t sequence;
     struct order_t *next;
 } order_t;
 
@@ -33,6 +80,31 @@ typedef struct server_t
     uint64_t port;
 } server_t;
 
+typedef struct md_symbol_t
+{
+    char symbol[10];
+    uint64_t sequence;
+} md_symbol_t;
+
+typedef struct md_feed_t
+{
+    uint64_t channel;
+    uint64_t subscriptions;
+    struct md_symbol_t *subscribed;
+    char session[MD_SESSION_LEN];
+    uint64_t next_sequence;
+    uint64_t replay_sequence;
+    server_t *addr_rewind;
+    uint64_t symbols;
+    struct md_symbol_t synced[MD_MAX_SYMBOLS];
+    uint64_t snapshot_sequence;
+    struct order_t *snapshot;
+    struct order_t *snapshot_tail;
+    uint64_t snapshot_orders;
+    uint16_t lengths[MD_REPLAY_RING_SIZE];
+    char messages[MD_REPLAY_RING_SIZE][MD_MAX_MESSAGE_LEN];
+} md_feed_t;
+
 // Message specifications
 typedef struct order_gateway_request_message_t
 {
@@ -51,4 +123,168 @@ typedef struct order_gateway_response_message_t
 
 } __attribute__((packed)) order_gateway_response_message_t;
 
+// Binary order entry messages, all integers are in network byte order. Message type is the first byte of the frame,
+// it is uppercase letter, so it doesn't collide with text orders, which start with lowercase customer id.
+typedef struct order_entry_logon_message_t
+{
+    char type;
+    char cid[36];
+
+} __attribute__((packed)) order_entry_logon_message_t;
+
+typedef struct order_entry_order_message_t
+{
+    char type;
+    uint64_t t_client;
+    uint8_t operation;
+    char symbol[10];
+    uint64_t quantity;
+    uint64_t price;
+
+} __attribute__((packed)) order_entry_order_message_t;
+
+typedef struct order_entry_cancel_message_t
+{
+    char type;
+    uint64_t t_client;
+    uint64_t order_id;
+
+} __attribute__((packed)) order_entry_cancel_message_t;
+
+typedef struct order_entry_replace_message_t
+{
+    char type;
+    uint64_t t_client;
+    uint64_t order_id;
+    uint64_t quantity;
+    uint64_t price;
+
+} __attribute__((packed)) order_entry_replace_message_t;
+
+typedef struct order_entry_ack_message_t
+{
+    char type;
+    uint64_t t_client;
+    uint64_t order_id;
+    uint64_t ts_ack;
+
+} __attribute__((packed)) order_entry_ack_message_t;
+
+// Market data messages, all integers are in network byte order and timestamps are nanoseconds since midnight.
+// Datagram starts with the header and each message is prefixed with 2 bytes of its length.
+// Retransmission request has the same layout as the header, its response is the header followed by the messages.
+typedef struct md_packet_header_t
+{
+    char session[MD_SESSION_LEN];
+    uint64_t sequence;
+    uint16_t count;
+
+} __attribute__((packed)) md_packet_header_t;
+
+typedef struct md_system_event_message_t
+{
+    char type;
+    uint64_t timestamp;
+    char event_code;
+
+} __attribute__((packed)) md_system_event_message_t;
+
+typedef struct md_add_order_message_t
+{
+    char type;
+    uint64_t timestamp;
+    uint64_t order_id;
+    char side;
+    uint64_t shares;
+    char stock[10];
+    uint64_t price;
+
+} __attribute__((packed)) md_add_order_message_t;
+
+typedef struct md_order_executed_message_t
+{
+    char type;
+    uint64_t timestamp;
+    uint64_t order_id;
+    uint64_t executed_shares;
+
+} __attribute__((packed)) md_order_executed_message_t;
+
+typedef struct md_order_cancel_message_t
+{
+    char type;
+    uint64_t timestamp;
+    uint64_t order_id;
+    uint64_t cancelled_shares;
+
+} __attribute__((packed)) md_order_cancel_message_t;
+
+typedef struct md_snapshot_message_t
+{
+    char type;
+    uint64_t timestamp;
+    char stock[10];
+    uint64_t sequence;
+    uint64_t orders;
+
+} __attribute__((packed)) md_snapshot_message_t;
+
+typedef struct md_quote_message_t
+{
+    char type;
+    uint64_t timestamp;
+    char stock[10];
+    uint64_t bid_price;
+    uint64_t bid_size;
+    uint64_t ask_price;
+    uint64_t ask_size;
+
+} __attribute__((packed)) md_quote_message_t;
+
+typedef struct md_trade_message_t
+{
+    char type;
+    uint64_t timestamp;
+    char side;
+    uint64_t shares;
+    char stock[10];
+    uint64_t price;
+    uint64_t match_number;
+
+} __attribute__((packed)) md_trade_message_t;
+
+// Directory request is the number of symbols followed by the symbols, the response is the header followed
+// by all channels and by the channel of each requested symbol. Multicast groups are IPv4 addresses.
+typedef struct md_directory_request_t
+{
+    uint16_t count;
+
+} __attribute__((packed)) md_directory_request_t;
+
+typedef struct md_directory_header_t
+{
+    char session[MD_SESSION_LEN];
+    uint16_t channels;
+    uint16_t count;
+
+} __attribute__((packed)) md_directory_header_t;
+
+typedef struct md_directory_channel_t
+{
+    uint16_t channel;
+    uint32_t group;
+    uint16_t port;
+    uint32_t snapshot_group;
+    uint16_t snapshot_port;
+    uint16_t rewind_port;
+
+} __attribute__((packed)) md_directory_channel_t;
+
+typedef struct md_directory_symbol_t
+{
+    char stock[10];
+    uint16_t channel;
+
+} __attribute__((packed)) md_directory_symbol_t;
+
 #endif /* _MY_HEADER_H_ */
\ No newline at end of file
@@ -4,25 +4,503 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <arpa/inet.h>
 #include <time.h>
-#include <hiredis/hiredis.h>
+#include <byteswap.h>
 
 // Local code
 #include "comm.h"
 #include "helper.h"
 #include "matching_engine.h"
+#include "symbol_directory.h"
+#include "customer_directory.h"
 #include "serializers.h"
+#include "pool.h"
+#include "persistence.h"
+#include "md_publisher.h"
+#include "log.h"
+
+// Define aux functions
+static uint64_t set_non_blocking(int64_t sd)
+{
+    /* Helper function to switch the socket to non-blocking mode, which is required for edge-triggered epoll */
+    int flags = fcntl(sd, F_GETFL, 0);
+    if (flags < 0 || fcntl(sd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        return 1;
+    }
+
+    // Success
+    return 0;
+}
+
+static void add_ready_session(session_t **ready_head, session_t **ready_tail, session_t *session)
+{
+    /* Helper function to add the session to the end of the list of sessions, which have data to read */
+    session->is_ready = true;
+    session->next_ready = NULL;
+    if (*ready_tail == NULL)
+    {
+        *ready_head = session;
+    }
+    else
+    {
+        (*ready_tail)->next_ready = session;
+    }
+    *ready_tail = session;
+}
+
+static void close_session(int64_t epfd, session_t *session)
+{
+    /* Helper function to close the session. If the session is still in the ready list,
+       memory is released when it is taken from the list. */
+    if (!session->is_closed)
+    {
+        LOG_DEBUG("Session from %s on %lu is closed", session->ip, session->port);
+        epoll_ctl(epfd, EPOLL_CTL_DEL, session->sd, NULL);
+        close(session->sd);
+        session->is_closed = true;
+    }
+
+    if (!session->is_ready)
+    {
+        free(session->write_buffer);
+        free(session);
+    }
+}
+
+static uint64_t flush_session(session_t *session)
+{
+    /* Helper function to send the write queue of the session until the kernel buffer is full.
+       The rest is sent when epoll reports the socket writable again. */
+    while (session->write_offset < session->write_length)
+    {
+        int64_t n = send(session->sd,
+                         session->write_buffer + session->write_offset,
+                         session->write_length - session->write_offset,
+                         MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return 0;
+            }
+            else if (errno == EINTR)
+            {
+                continue;
+            }
+            return 1;
+        }
+        session->write_offset += n;
+    }
+
+    // Write queue is empty
+    session->write_offset = 0;
+    session->write_length = 0;
+
+    // Success
+    return 0;
+}
+
+static uint64_t queue_session_frame(session_t *session, void *payload, uint64_t length)
+{
+    /* Helper function to add the framed message to the write queue of the session */
+
+    // Drop clients, which don't read their acknowledgements
+    uint64_t required = session->write_length + ORDER_FRAME_HEADER_LEN + length;
+    if (required > ORDER_SESSION_MAX_WRITE_QUEUE)
+    {
+        LOG_ERROR("Write queue of session from %s on %lu is full", session->ip, session->port);
+        return 1;
+    }
+
+    // Grow the write queue
+    if (required > session->write_capacity)
+    {
+        uint64_t capacity = session->write_capacity == 0 ? ORDER_SESSION_BUFFER_LEN : session->write_capacity * 2;
+        while (capacity < required)
+        {
+            capacity *= 2;
+        }
+        char *write_buffer = realloc(session->write_buffer, capacity);
+        if (write_buffer == NULL)
+        {
+            LOG_ERROR("Unable to allocate memory for write queue");
+            return 1;
+        }
+        session->write_buffer = write_buffer;
+        session->write_capacity = capacity;
+    }
+
+    // Add frame
+    uint16_t length_be = htons(length);
+    memcpy(session->write_buffer + session->write_length, &length_be, ORDER_FRAME_HEADER_LEN);
+    memcpy(session->write_buffer + session->write_length + ORDER_FRAME_HEADER_LEN, payload, length);
+    session->write_length += ORDER_FRAME_HEADER_LEN + length;
+
+    // Success
+    return 0;
+}
+
+static uint64_t reject_order(session_t *session, char *payload, uint64_t length)
+{
+    /* Helper function to queue the acknowledgement with order id `0` for the order, which can't be placed. Only the order
+       is rejected, the session stays open and the acknowledgements of the next orders keep following them in sequence. */
+    if (payload[0] == ORDER_ENTRY_ORDER || payload[0] == ORDER_ENTRY_CANCEL || payload[0] == ORDER_ENTRY_REPLACE)
+    {
+        // Client time follows the type in all binary messages, it is copied back in network byte order
+        order_entry_ack_message_t ack;
+        memset(&ack, 0, sizeof(ack));
+        ack.type = ORDER_ENTRY_ACK;
+        if (length >= sizeof(ack.type) + sizeof(ack.t_client))
+        {
+            memcpy(&ack.t_client, payload + sizeof(ack.type), sizeof(ack.t_client));
+        }
+        ack.ts_ack = bswap_64(get_time_nanoseconds_since_midnight(get_time_nanoseconds_midnight()));
+        return queue_session_frame(session, &ack, sizeof(ack)) != 0 ? 15 : 0;
+    }
+
+    char server_message[MAX_MSG_LEN];
+    int64_t ack_length = snprintf(server_message, sizeof(server_message), "%lu:0", time(NULL));
+    return queue_session_frame(session, server_message, ack_length) != 0 ? 15 : 0;
+}
+
+static void update_customer(matching_engine_t *me, customer_directory_t *customers, char *cid, char *ip)
+{
+    /* Helper function to update CID to IP mapping and to pass the changed mapping to the persistence thread */
+    uint64_t customer_id = intern_customer(customers, cid);
+    if (customer_id != MAX_CUSTOMERS && update_customer_ip(customers, customer_id, ip) && me->persistence != NULL)
+    {
+        persistence_event_t event;
+        event.type = PERSIST_CUSTOMER;
+        memcpy(event.customer.cid, cid, sizeof(event.customer.cid));
+        memcpy(event.customer.ip, ip, sizeof(event.customer.ip));
+        persist_event(me->persistence, &event);
+    }
+}
+
+static uint64_t process_logon(
+    session_t *session,
+    char *payload,
+    uint64_t length,
+    matching_engine_t *me,
+    customer_directory_t *customers)
+{
+    /* Helper function to bind the session to the customer, binary orders of the session are placed on its behalf */
+    if (length != sizeof(order_entry_logon_message_t))
+    {
+        LOG_ERROR("Invalid logon message from %s", session->ip);
+        return 17;
+    }
+    order_entry_logon_message_t *message = (order_entry_logon_message_t *)payload;
+    if (message->cid[0] == '\0')
+    {
+        LOG_ERROR("Logon without customer id from %s", session->ip);
+        return 17;
+    }
+
+    // Keep customer id in the session and update CID to IP mapping only once
+    memcpy(session->cid, message->cid, sizeof(message->cid));
+    session->cid[sizeof(message->cid)] = '\0';
+    session->is_logged_on = true;
+    update_customer(me, customers, session->cid, session->ip);
+    LOG_INFO("Session from %s on %lu is logged on as '%s'", session->ip, session->port, session->cid);
+
+    // Success
+    return 0;
+}
+
+static uint64_t process_binary_order(
+    session_t *session,
+    char *payload,
+    uint64_t length,
+    uint64_t *order_number,
+    matching_engine_t *me)
+{
+    /* Helper function to decode the binary order, cancel or replace in place and to pass it to the matching engine */
+    if (!session->is_logged_on)
+    {
+        LOG_ERROR("Binary order from %s before logon is rejected", session->ip);
+        return reject_order(session, payload, length);
+    }
+
+    // Each time new order is received, increment order number
+    (*order_number)++;
+
+    // Read clients order from wire and resolve its symbol once for the matching engine
+    order_t *order = deserialize_order_binary(payload, length, session->cid, *order_number, &me->orders);
+    if (order == NULL)
+    {
+        LOG_ERROR("Unable to read binary order from %s, it is rejected", session->ip);
+        return reject_order(session, payload, length);
+    }
+    if (order->operation <= 1)
+    {
+        order->symbol_id = intern_symbol(&me->symbols, order->symbol);
+    }
+    LOG_DEBUG("Binary order %lu from client '%s'", order->oid, session->cid);
+
+    // Queue response to client, acknowledgements are flushed together after the batch
+    order_entry_ack_message_t ack;
+    ack.type = ORDER_ENTRY_ACK;
+    ack.t_client = bswap_64(order->t_client);
+    ack.order_id = bswap_64(order->oid);
+    ack.ts_ack = bswap_64(order->t_server);
+    if (queue_session_frame(session, &ack, sizeof(ack)) != 0)
+    {
+        pool_free(&me->orders, order);
+        return 15;
+    }
+
+    // Update order book
+    match_trade(me, order, false);
+
+    // Success
+    return 0;
+}
+
+static uint64_t process_text_order(
+    session_t *session,
+    char *payload,
+    uint64_t length,
+    uint64_t *order_number,
+    matching_engine_t *me,
+    customer_directory_t *customers)
+{
+    /* Helper function to parse the colon-delimited order and to pass it to the matching engine */
+
+    // Copy the order text out of the frame, so that it is terminated
+    char client_message[MAX_MSG_LEN];
+    memcpy(client_message, payload, length);
+    client_message[length] = '\0';
+    LOG_DEBUG("Order from client: %s", client_message);
+
+    // Each time new order is received, increment order number
+    (*order_number)++;
+
+    // Update CID to IP mapping
+    char order_customer_id_buf[37];
+    char *order_customer_id = get_customer_id(client_message, order_customer_id_buf);
+    if (order_customer_id == NULL || order_customer_id[0] == '\0')
+    {
+        LOG_ERROR("Unable to extract customer id from order of %s, it is rejected", session->ip);
+        return reject_order(session, payload, length);
+    }
+    update_customer(me, customers, order_customer_id, session->ip);
+
+    // Read clients order from wire and resolve its symbol once for the matching engine
+    order_t *order = deserialize_order_wire(client_message, *order_number, &me->orders);
+    if (order == NULL)
+    {
+        LOG_ERROR("Unable to read order from %s, it is rejected", session->ip);
+        return reject_order(session, payload, length);
+    }
+    if (order->operation <= 1)
+    {
+        order->symbol_id = intern_symbol(&me->symbols, order->symbol);
+    }
+
+    // Queue response to client, acknowledgements are flushed together after the batch
+    char server_message[MAX_MSG_LEN];
+    int64_t ack_length = snprintf(server_message, sizeof(server_message), "%lu:%lu", time(NULL), *order_number);
+    if (queue_session_frame(session, server_message, ack_length) != 0)
+    {
+        pool_free(&me->orders, order);
+        return 15;
+    }
+
+    // Update order book
+    match_trade(me, order, false);
+
+    // Success
+    return 0;
+}
+
+static uint64_t process_session_frames(
+    session_t *session,
+    uint64_t *order_number,
+    matching_engine_t *me,
+    customer_directory_t *customers)
+{
+    /* Helper function to pass all complete frames of the session to the matching engine in arrival order.
+       Each message is a frame with 2 bytes length in network byte order, followed by either binary message,
+       which starts with its uppercase type, or by the order text. */
+    uint64_t offset = 0;
+
+    while (session->read_length - offset >= ORDER_FRAME_HEADER_LEN)
+    {
+        uint16_t frame_length_be;
+        memcpy(&frame_length_be, session->read_buffer + offset, ORDER_FRAME_HEADER_LEN);
+        uint64_t frame_length = ntohs(frame_length_be);
+        if (frame_length == 0 || frame_length >= MAX_MSG_LEN)
+        {
+            LOG_ERROR("Invalid frame length '%lu' from %s", frame_length, session->ip);
+            return 17;
+        }
+        if (session->read_length - offset < ORDER_FRAME_HEADER_LEN + frame_length)
+        {
+            break;
+        }
+        char *payload = session->read_buffer + offset + ORDER_FRAME_HEADER_LEN;
+        offset += ORDER_FRAME_HEADER_LEN + frame_length;
+
+        // Dispatch message per its type
+        uint64_t status = 0;
+        if (payload[0] == ORDER_ENTRY_ORDER || payload[0] == ORDER_ENTRY_CANCEL || payload[0] == ORDER_ENTRY_REPLACE)
+        {
+            status = process_binary_order(session, payload, frame_length, order_number, me);
+        }
+        else if (payload[0] == ORDER_ENTRY_LOGON)
+        {
+            status = process_logon(session, payload, frame_length, me, customers);
+        }
+        else
+        {
+            status = process_text_order(session, payload, frame_length, order_number, me, customers);
+        }
+        // Malformed orders are rejected one by one, only the broken framing or logon closes the session
+        if (status != 0)
+        {
+            return status;
+        }
+    }
+
+    // Keep the incomplete frame at the start of the buffer
+    session->read_length -= offset;
+    memmove(session->read_buffer, session->read_buffer + offset, session->read_length);
+
+    // Success
+    return 0;
+}
+
+static uint64_t read_session(
+    session_t *session,
+    uint64_t *order_number,
+    matching_engine_t *me,
+    customer_directory_t *customers,
+    bool *is_drained)
+{
+    /* Helper function to read the session within its read budget. As epoll is edge-triggered, `is_drained` is set
+       only when the socket has no more data, otherwise the session must be served again later. */
+    *is_drained = false;
+
+    for (uint64_t i = 0; i < ORDER_SESSION_READ_BUDGET; i++)
+    {
+        // Recieve next chunk of orders from client
+        int64_t n = recv(session->sd,
+                         session->read_buffer + session->read_length,
+                         sizeof(session->read_buffer) - session->read_length,
+                         0);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                *is_drained = true;
+                break;
+            }
+            else if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR("Couldn't receive from %s", session->ip);
+            return 14;
+        }
+        // Client closed the session, acknowledgements for its last orders are still sent
+        else if (n == 0)
+        {
+            flush_session(session);
+            return 1;
+        }
+        session->read_length += n;
+
+        // Process all complete frames, acknowledgements of the orders before the broken frame are still sent
+        uint64_t status = process_session_frames(session, order_number, me, customers);
+        if (status != 0)
+        {
+            flush_session(session);
+            return status;
+        }
+    }
+
+    // Send acknowledgements for the batch
+    if (flush_session(session) != 0)
+    {
+        LOG_ERROR("Can't send response to client");
+        return 15;
+    }
+
+    // Success
+    return 0;
+}
+
+static void accept_sessions(int64_t epfd, int64_t sd)
+{
+    /* Helper function to accept all pending connections and to add them to epoll */
+    while (1)
+    {
+        struct sockaddr_in client_addr;
+        u_int32_t client_size = sizeof(client_addr);
+        int64_t csd = accept(sd, (struct sockaddr *)&client_addr, &client_size);
+        if (csd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                LOG_ERROR("Unable to accept connection");
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+
+        // Create session
+        session_t *session = calloc(1, sizeof(session_t));
+        if (session == NULL || set_non_blocking(csd) != 0)
+        {
+            LOG_ERROR("Unable to create session");
+            free(session);
+            close(csd);
+            continue;
+        }
+        session->sd = csd;
+        session->port = ntohs(client_addr.sin_port);
+        if (inet_ntop(AF_INET, &client_addr.sin_addr, session->ip, INET_ADDRSTRLEN) == NULL)
+        {
+            perror("Error: Uncompatible IP Address: ");
+            free(session);
+            close(csd);
+            continue;
+        }
+
+        // Watch the session for input and for free space to send the queued acknowledgements
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = session;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, csd, &event) < 0)
+        {
+            perror("Error: Cannot add session to epoll: ");
+            free(session);
+            close(csd);
+            continue;
+        }
+
+        LOG_DEBUG("Session from %s on %lu is opened", session->ip, session->port);
+    }
+}
 
 // Define function prototypes
 uint64_t receive_orders(
     server_t *addr_order,
     u_int64_t orders,
-    trading_trie_t *tt,
-    cid_ip_t *cid_ip_map,
-    redisContext *red_con)
+    matching_engine_t *me,
+    customer_directory_t *customers)
 {
     // Initialize order number
     uint64_t order_number = orders;
@@ -40,11 +518,6 @@ uint64_t receive_orders(
     printf("%lu: Socket created successfully\n",
            get_time_nanoseconds_since_midnight(time_midnight));
 
-    // Initialize message buffer
-    char server_message[MAX_MSG_LEN], client_message[MAX_MSG_LEN];
-    memset(server_message, '\0', sizeof(server_message));
-    memset(client_message, '\0', sizeof(client_message));
-
     // Initialize server address (Destination IP and port, what this server is listening on)
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
@@ -77,7 +550,7 @@ uint64_t receive_orders(
            addr_order->protocol);
 
     // Listen for incoming connections
-    if (listen(sd, 1) < 0)
+    if (listen(sd, SOMAXCONN) < 0)
     {
         perror("Error: Cannot listen on socket: ");
         return 5;
@@ -88,94 +561,135 @@ uint64_t receive_orders(
            addr_order->port,
            addr_order->protocol);
 
-    // Continously receive orders
-    while (1)
+    // Listening socket is non-blocking, so that all pending connections are accepted on one event
+    if (set_non_blocking(sd) != 0)
     {
-        // Each time new order is received, increment order number
-        order_number++;
+        perror("Error: Cannot set socket option: ");
+        return 3;
+    }
 
-        // Create client socket
-        struct sockaddr_in client_addr;
-        u_int32_t client_size = sizeof(client_addr);
-        int64_t csd = accept(sd, (struct sockaddr *)&client_addr, &client_size);
-        if (csd < 0)
-        {
-            printf("%lu: Unable to accept connection on %s at %lu/%lu.\n",
-                   get_time_nanoseconds_since_midnight(time_midnight),
-                   addr_order->ip,
-                   addr_order->port,
-                   addr_order->protocol);
-            return 6;
-        }
+    // Create epoll, listening socket is marked with `NULL`, sessions with their pointers
+    int64_t epfd = epoll_create1(0);
+    if (epfd < 0)
+    {
+        perror("Error: Cannot create epoll: ");
+        return 6;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = NULL;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, sd, &event) < 0)
+    {
+        perror("Error: Cannot add socket to epoll: ");
+        return 6;
+    }
+
+    // Sessions, which still have data after their read budget is used, are served round-robin
+    session_t *ready_head = NULL;
+    session_t *ready_tail = NULL;
+    struct epoll_event events[ORDER_MAX_EVENTS];
 
-        // Get IP of connected host
-        char received_ip[INET_ADDRSTRLEN];
-        memset(received_ip, 0, sizeof(received_ip));
-        if (inet_ntop(AF_INET, &client_addr.sin_addr, received_ip, INET_ADDRSTRLEN) == NULL)
+    // Continously serve sessions, each of them streams many orders
+    while (1)
+    {
+        // Don't wait for new events, if there are sessions to be served
+        int64_t n = epoll_wait(epfd, events, ORDER_MAX_EVENTS, ready_head == NULL ? -1 : 0);
+        if (n < 0)
         {
-            perror("Error: Uncompatible IP Address: ");
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("Error: Cannot wait for events: ");
             return 7;
         }
 
-        printf("%lu: Recived order from %s on %i/%lu\n",
-               get_time_nanoseconds_since_midnight(time_midnight),
-               received_ip,
-               ntohs(client_addr.sin_port),
-               addr_order->protocol);
-
-        // Recieve order from client
-        if (recv(csd, client_message, sizeof(client_message), 0) < 0)
+        // Add sessions with new events to the end of the ready list in the order of their arrival
+        for (int64_t i = 0; i < n; i++)
         {
-            printf("%lu: Couldn't receive\n",
-                   get_time_nanoseconds_since_midnight(time_midnight));
-            return 14;
-        }
-        printf("%lu: Order from client: %s\n",
-               get_time_nanoseconds_since_midnight(time_midnight),
-               client_message);
+            session_t *session = events[i].data.ptr;
 
-        // Update CID to IP mapping
-        char *order_customer_id = get_customer_id(client_message);
-        if (order_customer_id == NULL)
-        {
-            printf("%lu: Unable to extract customer id from order\n",
-                   get_time_nanoseconds_since_midnight(time_midnight));
-            return 14;
-        }
-        update_cid_ip(cid_ip_map, order_customer_id, received_ip, red_con);
+            // New connections
+            if (session == NULL)
+            {
+                accept_sessions(epfd, sd);
+                continue;
+            }
 
-        // Read clients order from wire
-        order_t *order = deserialize_order_wire(client_message, order_number);
+            // Socket is writable again, send the rest of acknowledgements
+            if (events[i].events & EPOLLOUT)
+            {
+                if (flush_session(session) != 0)
+                {
+                    close_session(epfd, session);
+                    continue;
+                }
+            }
 
-        // Send response to client
-        sprintf(server_message, "%lu:%lu", time(NULL), order_number);
+            // Queue session for reading
+            if ((events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && !session->is_ready)
+            {
+                add_ready_session(&ready_head, &ready_tail, session);
+            }
+        }
 
-        if (send(csd, server_message, strlen(server_message), 0) < 0)
+        // Serve every session in the ready list once
+        session_t *last = ready_tail;
+        while (ready_head != NULL)
         {
-            printf("%lu: Can't send response to client\n",
-                   get_time_nanoseconds_since_midnight(time_midnight));
-            return 15;
-        }
-        printf("%lu: Confirmation send to %s on %hu/%lu\n",
-               get_time_nanoseconds_since_midnight(time_midnight),
-               received_ip,
-               htons(client_addr.sin_port),
-               addr_order->protocol);
+            session_t *session = ready_head;
+            bool is_last = session == last;
+            ready_head = session->next_ready;
+            if (ready_head == NULL)
+            {
+                ready_tail = NULL;
+            }
+            session->is_ready = false;
+
+            if (session->is_closed)
+            {
+                close_session(epfd, session);
+            }
+            else
+            {
+                bool is_drained = false;
+                uint64_t status = read_session(session, &order_number, me, customers, &is_drained);
+                if (status != 0)
+                {
+                    close_session(epfd, session);
+                }
+                // Budget is used, but data is left, so the session goes to the end of the list
+                else if (!is_drained)
+                {
+                    add_ready_session(&ready_head, &ready_tail, session);
+                }
+            }
 
-        // Close client socket
-        close(csd);
+            // During bursts the partial datagram of trades waits for more of them not longer than the latency bound
+            if (me->last_sale != NULL && me->last_sale->packets > 0 &&
+                get_time_microseconds() - me->last_sale->t_open >= me->last_sale->max_delay &&
+                flush_md_packets(me->last_sale) != 0)
+            {
+                LOG_ERROR("Unable to send trades on the Last Sale channel");
+            }
 
-        // Update trading trie
-        match_trade(tt, order, red_con, false);
+            if (is_last)
+            {
+                break;
+            }
+        }
 
-        // Cleanup
-        memset(server_message, '\0', sizeof(server_message));
-        memset(client_message, '\0', sizeof(client_message));
+        // Trades matched during the pass are sent together before waiting for more orders
+        if (me->last_sale != NULL && me->last_sale->packets > 0 && flush_md_packets(me->last_sale) != 0)
+        {
+            LOG_ERROR("Unable to send trades on the Last Sale channel");
+        }
     }
 
     // Cleanup
+    close(epfd);
     close(sd);
-    free_cid_ip_map(cid_ip_map);
 
     // Return success if everything is OK
     return 0;
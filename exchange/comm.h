@@ -1,6 +1,5 @@
 // Preprocessing
 #include <stdint.h>
-#include <hiredis/hiredis.h>
 
 // Local code
 #include "types.h"
@@ -9,6 +8,5 @@
 uint64_t receive_orders(
     server_t *addr_order,
     u_int64_t orders,
-    trading_trie_t *tt,
-    cid_ip_t *cid_ip_map,
-    redisContext *red_con);
\ No newline at end of file
+    matching_engine_t *me,
+    customer_directory_t *customers);
\ No newline at end of file
@@ -0,0 +1,86 @@
+/* This file contains the directory of customers: open-addressing hash table, which interns customer ids
+   into dense ids, so that the endpoint of the customer is found without walking the list of all customers */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Local headers
+#include "customer_directory.h"
+#include "log.h"
+
+// Define aux functions
+static uint64_t probe_customer(customer_directory_t *cd, char *cid)
+{
+    /* Helper function to find the slot of the customer or the free slot, where the customer would be added */
+    uint64_t hash = 14695981039346656037UL;
+    for (uint64_t i = 0; i < 36 && cid[i] != '\0'; i++)
+    {
+        hash ^= (unsigned char)cid[i];
+        hash *= 1099511628211UL;
+    }
+
+    // Probe the table starting from the hashed slot
+    uint64_t slot = hash & (CUSTOMER_DIRECTORY_SIZE - 1);
+    while (cd->slots[slot].cid[0] != '\0' && strncmp(cd->slots[slot].cid, cid, 36) != 0)
+    {
+        slot = (slot + 1) & (CUSTOMER_DIRECTORY_SIZE - 1);
+    }
+
+    return slot;
+}
+
+uint64_t find_customer(customer_directory_t *cd, char *cid)
+{
+    /* Helper function to get id of the customer. Returns MAX_CUSTOMERS if the customer is unknown. */
+    uint64_t slot = probe_customer(cd, cid);
+
+    return cd->slots[slot].cid[0] == '\0' ? MAX_CUSTOMERS : cd->slots[slot].customer_id;
+}
+
+uint64_t intern_customer(customer_directory_t *cd, char *cid)
+{
+    /* Helper function to get id of the customer, adding the customer to directory if it is new.
+       Returns MAX_CUSTOMERS if the customer id is empty or the directory is full. */
+
+    // Empty customer id can't be told from the free slot, so it would get the new id every time
+    if (cid[0] == '\0')
+    {
+        return MAX_CUSTOMERS;
+    }
+
+    uint64_t slot = probe_customer(cd, cid);
+    if (cd->slots[slot].cid[0] != '\0')
+    {
+        return cd->slots[slot].customer_id;
+    }
+
+    // Add new customer to the free slot
+    if (cd->customers == MAX_CUSTOMERS)
+    {
+        LOG_ERROR("Customer directory is full, unable to add '%s'", cid);
+        return MAX_CUSTOMERS;
+    }
+
+    strncpy(cd->slots[slot].cid, cid, 36);
+    cd->slots[slot].customer_id = cd->customers;
+    strncpy(cd->cids[cd->customers], cid, 36);
+
+    return cd->customers++;
+}
+
+bool update_customer_ip(customer_directory_t *cd, uint64_t customer_id, char *ip)
+{
+    /* Helper function to update IP of the customer. Returns `true` if the IP is new and needs to be persisted. */
+    if (strncmp(cd->ips[customer_id], ip, INET_ADDRSTRLEN - 1) == 0)
+    {
+        return false;
+    }
+
+    strncpy(cd->ips[customer_id], ip, INET_ADDRSTRLEN - 1);
+    LOG_INFO("Updated CID to IP mapping: CID '%s' with IP '%s'.", cd->cids[customer_id], ip);
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+/* This file contains header for the directory of customers, which maps customer ids to dense ids and endpoints */
+
+// Preprocessor directives
+#include <stdint.h>
+#include <stdbool.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t find_customer(customer_directory_t *cd, char *cid);
+uint64_t intern_customer(customer_directory_t *cd, char *cid);
+bool update_customer_ip(customer_directory_t *cd, uint64_t customer_id, char *ip);
\ No newline at end of file
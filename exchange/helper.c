@@ -5,110 +5,98 @@
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <hiredis/hiredis.h>
 #include <arpa/inet.h>
 
 // Local code
 #include "helper.h"
+#include "log.h"
+
+// Number of commands appended to the Redis pipeline, which replies are not read yet
+static uint64_t redis_pending_replies = 0;
 
 // Define aux functions
-char *get_customer_id(char *message)
+static uint64_t append_redis_command(redisContext *red_con, const char *format, ...)
 {
-    /* Helper function to subtract the Customer ID from the message*/
-
-    // Initialize customer id
-    char *cid = (char *)calloc(1, MAX_MSG_LEN * sizeof(char));
-    if (cid == NULL)
+    /* Helper function to add the command to the Redis pipeline without waiting for the reply.
+       The pipeline is flushed once it is too deep, so that the output buffer doesn't grow unbounded. */
+    va_list args;
+    va_start(args, format);
+    int status = redisvAppendCommand(red_con, format, args);
+    va_end(args);
+    if (status != REDIS_OK)
     {
-        printf("%lu: Unable to allocate memory for customer id\n", time(NULL));
-        return NULL;
+        LOG_ERROR("Unable to append command to Redis pipeline");
+        return 1;
     }
+    redis_pending_replies++;
 
-    // Extract customer id
-    int i = 0;
-    while (message[i] != ':')
+    if (redis_pending_replies >= REDIS_PIPELINE_DEPTH)
     {
-        cid[i] = message[i];
-        i++;
+        return flush_redis_pipeline(red_con);
     }
 
-    // Return customer id
-    return cid;
+    // Success
+    return 0;
 }
 
-void update_cid_ip(cid_ip_t *cid_ip_map, char *cid, char *ip, redisContext *red_con)
+uint64_t flush_redis_pipeline(redisContext *red_con)
 {
-    /* Helper function to update the CID to IP mapping*/
-
-    cid_ip_t *head = cid_ip_map;
-    bool is_updated = false;
+    /* Helper function to send all pipelined commands in one write and to read their replies.
+       It is called once per batch of orders, so the batch costs a single round trip. Returns number of errors. */
+    uint64_t errors = 0;
 
-    // Check if the existing mapping is blank
-    if (head->cid[0] == '\0')
-    {
-        memcpy(head->cid, cid, 36);
-        memcpy(head->ip, ip, 15);
-
-        is_updated = true;
-    }
-    // In case it is not null, start futher comparisson
-    else
+    while (redis_pending_replies > 0)
     {
-        // Check if the current client id is this
-        while (memcmp(head->cid, cid, 36) != 0)
+        redisReply *red_rep = NULL;
+        if (redisGetReply(red_con, (void **)&red_rep) != REDIS_OK)
         {
-            // Check if the next mapping doesn't exist
-            if (head->next == NULL)
-            {
-                // Create a new mapping
-                head->next = malloc(sizeof(cid_ip_t));
-
-                // Set Customer ID in new mapping
-                head->next->cid = calloc(37, sizeof(char));
-                memcpy(head->next->cid, cid, 36);
-
-                // Set Customer IP in new mapping
-                head->next->ip = calloc(16, sizeof(char));
-                memcpy(head->next->ip, ip, 15);
-
-                head->next->next = NULL;
-
-                is_updated = true;
-            }
-            // Move to the next mapping
-            else
-            {
-                head = head->next;
-            }
+            LOG_ERROR("Unable to read replies from Redis pipeline: %s", red_con->errstr);
+            redis_pending_replies = 0;
+            return errors + 1;
         }
-    }
-
-    if (is_updated)
-    {
-        printf("%lu: Updated CID to IP mapping: CID '%s' with IP '%s'.\n", time(NULL), cid, ip);
+        redis_pending_replies--;
 
-        // Update the mapping in Redis
-        redisReply *red_rep = redisCommand(red_con, "HSET %s %s %s", REDIS_EXCHANGE_C2IP, cid, ip);
+        if (red_rep->type == REDIS_REPLY_ERROR)
+        {
+            LOG_ERROR("Redis command in pipeline failed: %s", red_rep->str);
+            errors++;
+        }
         freeReplyObject(red_rep);
     }
+
+    return errors;
 }
 
-void free_cid_ip_map(cid_ip_t *cid_ip_map)
+char *get_customer_id(char *message, char *cid)
 {
-    /* Helper function to free the CID to IP mapping*/
+    /* Helper function to subtract the Customer ID from the message into the buffer of 37 chars.
+       Return `NULL` if the message has no delimiter after Customer ID. */
 
-    // Initialize head
-    cid_ip_t *head = cid_ip_map;
+    // Extract customer id
+    int i = 0;
+    while (message[i] != ':' && message[i] != '\0' && i < 36)
+    {
+        cid[i] = message[i];
+        i++;
+    }
+    cid[i] = '\0';
 
-    // Free the mapping
-    while (head != NULL)
+    // Validate the delimiter is found
+    if (message[i] != ':')
     {
-        cid_ip_t *temp = head;
-        head = head->next;
-        free(temp->cid);
-        free(temp->ip);
-        free(temp);
+        return NULL;
     }
+
+    // Return customer id
+    return cid;
+}
+
+uint64_t add_cid_ip_to_redis(redisContext *red_con, char *cid, char *ip)
+{
+    /* Helper function to save the CID to IP mapping in Redis, the command is pipelined */
+    return append_redis_command(red_con, "HSET %s %s %s", REDIS_EXCHANGE_C2IP, cid, ip);
 }
 
 uint64_t add_order_to_redis(redisContext *red_con, order_t *order)
@@ -135,55 +123,52 @@ uint64_t add_order_to_redis(redisContext *red_con, order_t *order)
 
 uint64_t add_order_to_redis_details(redisContext *red_con, order_t *order)
 {
-    /* Helper function to create Redis hash for an order */
+    /* Helper function to create Redis hash for an order, the command is pipelined */
 
     // Create Hash with order details
-    redisReply *red_rep = redisCommand(red_con, "HSET %s:%lu cid %s t_client %lu t_server %lu symbol %s op %i price %.2f qty %i",
-                                       REDIS_EXCHANGE_ORDER_PREFIX,
-                                       order->oid,
-                                       order->cid,
-                                       order->t_client,
-                                       order->t_server,
-                                       order->symbol,
-                                       order->operation,
-                                       order->price,
-                                       order->quantity);
-    if (red_rep->str != NULL)
-    {
-        printf("%lu: Unable to create order details in Redis: %s\n", time(NULL), red_rep->str);
-        freeReplyObject(red_rep);
-        return 1;
-    }
-    else
-    {
-        printf("%lu: Order details are created in Redis.\n", time(NULL));
-        freeReplyObject(red_rep);
-    }
-
-    // Success
-    return 0;
+    uint64_t status = append_redis_command(red_con, "HSET %s:%lu cid %s t_client %lu t_server %lu symbol %s op %lu price %lu qty %lu",
+                                           REDIS_EXCHANGE_ORDER_PREFIX,
+                                           order->oid,
+                                           order->cid,
+                                           order->t_client,
+                                           order->t_server,
+                                           order->symbol,
+                                           order->operation,
+                                           order->price,
+                                           order->quantity);
+    LOG_TRACE("Order %lu details are queued to Redis.", order->oid);
+
+    return status;
 }
 
 uint64_t add_order_to_redis_hash(redisContext *red_con, order_t *order)
 {
-    /* Helper function to add an order to the Redis hash/queue with the orders */
+    /* Helper function to add an order to the Redis hash/queue with the orders, the command is pipelined */
 
     // Add order to the hash queue
-    redisReply *red_rep = redisCommand(red_con, "HSET %s %lu %lu", REDIS_EXCHANGE_A_ORDERS, order->oid);
-    if (red_rep->str != NULL)
-    {
-        printf("%lu: Unable to add order to the active queue in Redis: %s\n", time(NULL), red_rep->str);
-        freeReplyObject(red_rep);
-        return 1;
-    }
-    else
-    {
-        printf("%lu: Order is added to the active queue in Redis.\n", time(NULL));
-        freeReplyObject(red_rep);
-    }
+    uint64_t status = append_redis_command(red_con, "HSET %s %lu %lu", REDIS_EXCHANGE_A_ORDERS, order->oid, order->t_server);
+    LOG_TRACE("Order %lu is queued to the active queue in Redis.", order->oid);
 
-    // Success
-    return 0;
+    return status;
+}
+
+uint64_t remove_order_from_redis(redisContext *red_con, order_t *order)
+{
+    /* Helper function to remove the cancelled order from the Redis hash/queue with the active orders.
+       Order details are kept, as there may be notification about its fills pending. The command is pipelined. */
+    uint64_t status = append_redis_command(red_con, "HDEL %s %lu", REDIS_EXCHANGE_A_ORDERS, order->oid);
+    LOG_TRACE("Order %lu is queued for removal from the active queue in Redis.", order->oid);
+
+    return status;
+}
+
+uint64_t set_last_oid_to_redis(redisContext *red_con, uint64_t oid)
+{
+    /* Helper function to save the highest order id, which has a record in Redis, the command is pipelined */
+    uint64_t status = append_redis_command(red_con, "SET %s %lu", REDIS_EXCHANGE_LAST_OID, oid);
+    LOG_TRACE("Order id %lu is queued to Redis as the last one.", oid);
+
+    return status;
 }
 
 server_t *get_server(char *env_ip, char *env_port, uint64_t protocol)
@@ -223,58 +208,104 @@ server_t *get_server(char *env_ip, char *env_port, uint64_t protocol)
     return server;
 }
 
-uint64_t move_orders_to_exec_queue_redis(redisContext *red_con, order_t *orders)
+uint64_t add_book_event_to_redis(redisContext *red_con, book_event_t *event)
+{
+    /* Helper function to add the change of the resting order to the stream of book events, which is read by market_data.
+       The command is pipelined. */
+    uint64_t status = append_redis_command(red_con, "XADD %s MAXLEN ~ %lu * type %c oid %lu symbol %s op %lu price %lu qty %lu leaves %lu t %lu match %lu",
+                                           REDIS_EXCHANGE_BOOK_STREAM,
+                                           (uint64_t)REDIS_BOOK_STREAM_MAXLEN,
+                                           event->type,
+                                           event->oid,
+                                           event->symbol,
+                                           event->operation,
+                                           event->price,
+                                           event->quantity,
+                                           event->leaves,
+                                           event->t_server,
+                                           event->match_id);
+    LOG_TRACE("Book event '%c' of order %lu is queued to Redis.", event->type, event->oid);
+
+    return status;
+}
+
+uint64_t move_orders_to_exec_queue_redis(redisContext *red_con, execution_t *executions)
 {
-    /* Function to move orders from active_orders hash to executed_orders */
+    /* Function to add the fill of both orders to the stream of executions, which is read by the notifier,
+       update remaining quantity of the resting order and remove it from active_orders, if it is fully filled.
+       All commands are pipelined. */
 
-    order_t *head = orders;
+    execution_t *head = executions;
+    uint64_t status = 0;
 
-    // Page through all executed orders
+    // Page through all executions
     while (head != NULL)
     {
-        // Ignore placeholder
-        if (head->oid != 0)
+        // Add the fill of the aggressor order and of the resting order, entries carry everything needed to notify
+        status |= append_redis_command(red_con, "XADD %s MAXLEN ~ %lu * oid %lu cid %s t_server %lu t_exec %lu qty %lu leaves %lu",
+                                       REDIS_EXCHANGE_EXEC_STREAM,
+                                       (uint64_t)REDIS_EXEC_STREAM_MAXLEN,
+                                       head->aggressor_oid,
+                                       head->aggressor_cid,
+                                       head->aggressor_t_server,
+                                       head->t_server,
+                                       head->quantity,
+                                       head->aggressor_leaves);
+        status |= append_redis_command(red_con, "XADD %s MAXLEN ~ %lu * oid %lu cid %s t_server %lu t_exec %lu qty %lu leaves %lu",
+                                       REDIS_EXCHANGE_EXEC_STREAM,
+                                       (uint64_t)REDIS_EXEC_STREAM_MAXLEN,
+                                       head->resting_oid,
+                                       head->resting_cid,
+                                       head->resting_t_server,
+                                       head->t_server,
+                                       head->quantity,
+                                       head->resting_leaves);
+
+        // Remove fully filled resting order from active orders
+        if (head->resting_leaves == 0)
         {
-            // Add to executed orders hash
-            redisReply *red_rep1 = redisCommand(red_con, "HSET %s %lu %lu",
-                                                REDIS_EXCHANGE_E_ORDERS,
-                                                head->oid,
-                                                head->oid);
-
-            if (red_rep1->str != NULL)
-            {
-                printf("%lu: Unable to add order %lu to the executed queue in Redis: %s\n", time(NULL), head->oid, red_rep1->str);
-                freeReplyObject(red_rep1);
-                return 1;
-            }
-            else
-            {
-                printf("%lu: Order %lu is added to the executed queue in Redis.\n", time(NULL), head->oid);
-            }
-            freeReplyObject(red_rep1);
-
-            // Remove from active orders
-            redisReply *red_rep2 = redisCommand(red_con, "HDEL %s %lu",
-                                                REDIS_EXCHANGE_A_ORDERS,
-                                                head->oid);
-            if (red_rep2->str != NULL)
-            {
-                printf("%lu: Unable to delete order %lu from the active queue in Redis: %s\n", time(NULL), head->oid, red_rep2->str);
-                freeReplyObject(red_rep2);
-                return 1;
-            }
-            else
-            {
-                printf("%lu: Order %lu is deleted from the active queue in Redis.\n", time(NULL), head->oid);
-            }
-            freeReplyObject(red_rep2);
+            status |= append_redis_command(red_con, "HDEL %s %lu", REDIS_EXCHANGE_A_ORDERS, head->resting_oid);
         }
 
+        // Update remaining quantity of the resting order, it is kept for the execution notification as well
+        status |= append_redis_command(red_con, "HSET %s:%lu qty %lu", REDIS_EXCHANGE_ORDER_PREFIX, head->resting_oid, head->resting_leaves);
+        LOG_TRACE("Execution of orders %lu and %lu is queued to Redis.", head->aggressor_oid, head->resting_oid);
+
         head = head->next;
     }
 
-    // return success
-    return 0;
+    return status;
+}
+
+price_t parse_price(char *str)
+{
+    /* Helper function to convert decimal price text (e.g., `10.03`) to integer number of ticks.
+       Digits beyond the tick size are truncated, no floating point conversion is involved. */
+    price_t units = 0;
+    price_t fraction = 0;
+    uint64_t scale = PRICE_SCALE;
+
+    // Integer part
+    uint64_t i = 0;
+    while (str[i] >= '0' && str[i] <= '9')
+    {
+        units = units * 10 + (str[i] - '0');
+        i++;
+    }
+
+    // Fractional part
+    if (str[i] == '.')
+    {
+        i++;
+        while (str[i] >= '0' && str[i] <= '9' && scale > 1)
+        {
+            scale /= 10;
+            fraction += (str[i] - '0') * scale;
+            i++;
+        }
+    }
+
+    return units * PRICE_SCALE + fraction;
 }
 
 uint64_t get_time_nanoseconds_midnight()
@@ -282,9 +313,10 @@ uint64_t get_time_nanoseconds_midnight()
     /* Helper function to get time in nanoseconds at the midnight this day.
        Return `-1` in case of errors.*/
 
-    // Get current time in struct
+    // Get current time in struct, the reentrant call is safe to use from the matching and the persistence threads
     time_t now = time(NULL);
-    struct tm now_st = *localtime(&now);
+    struct tm now_st;
+    localtime_r(&now, &now_st);
 
     // Erase hours, minutes, seconds
     now_st.tm_hour = 0;
@@ -1,5 +1,6 @@
 // Preprocessor directives
 #include <stdint.h>
+#include <stdbool.h>
 #include <arpa/inet.h>
 #include <hiredis/hiredis.h>
 
@@ -7,13 +8,17 @@
 #include "types.h"
 
 // Declare function prototypes
-char *get_customer_id(char *message);
-void update_cid_ip(cid_ip_t *cid_ip_map, char *cid, char *ip, redisContext *red_con);
-void free_cid_ip_map(cid_ip_t *cid_ip_map);
+char *get_customer_id(char *message, char *cid);
+uint64_t add_cid_ip_to_redis(redisContext *red_con, char *cid, char *ip);
+uint64_t flush_redis_pipeline(redisContext *red_con);
 uint64_t add_order_to_redis(redisContext *red_con, order_t *order);
 uint64_t add_order_to_redis_details(redisContext *red_con, order_t *order);
 uint64_t add_order_to_redis_hash(redisContext *red_con, order_t *order);
-uint64_t move_orders_to_exec_queue_redis(redisContext *red_con, order_t *orders);
+uint64_t remove_order_from_redis(redisContext *red_con, order_t *order);
+uint64_t set_last_oid_to_redis(redisContext *red_con, uint64_t oid);
+uint64_t add_book_event_to_redis(redisContext *red_con, book_event_t *event);
+uint64_t move_orders_to_exec_queue_redis(redisContext *red_con, execution_t *executions);
 server_t *get_server(char *env_ip, char *env_port, uint64_t protocol);
+price_t parse_price(char *str);
 uint64_t get_time_nanoseconds_midnight();
 uint64_t get_time_nanoseconds_since_midnight(uint64_t midnigt);
\ No newline at end of file
@@ -0,0 +1,417 @@
+/* This file contains the append-only binary journal of the orders received by the matching engine. The journal file
+   is memory-mapped, so that appending the order is a copy of the fixed-size record, and replaying it at startup
+   is the sequential read of the file instead of crawling order keys in Redis. The snapshot of the books is written
+   periodically by the forked copy of the engine, so recovery is the snapshot plus the tail of the journal. */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// Local headers
+#include "journal.h"
+#include "matching_engine.h"
+#include "symbol_directory.h"
+#include "pool.h"
+#include "log.h"
+
+// Define aux functions
+static uint64_t map_journal(journal_t *journal, uint64_t capacity)
+{
+    /* Helper function to extend the journal file to the capacity and to map it to memory */
+    if (ftruncate(journal->fd, capacity) != 0)
+    {
+        perror("Error: Cannot extend journal: ");
+        return 1;
+    }
+
+    char *map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, journal->fd, 0);
+    if (map == MAP_FAILED)
+    {
+        perror("Error: Cannot map journal: ");
+        return 2;
+    }
+
+    journal->map = map;
+    journal->capacity = capacity;
+    journal->header = (journal_header_t *)map;
+
+    // Success
+    return 0;
+}
+
+static void order_to_record(order_t *order, journal_record_t *record)
+{
+    /* Helper function to copy the fields of the order, which are needed to match it again, to the record */
+    record->oid = order->oid;
+    record->t_client = order->t_client;
+    record->t_server = order->t_server;
+    record->operation = order->operation;
+    record->price = order->price;
+    record->quantity = order->quantity;
+    record->target_oid = order->target_oid;
+    memcpy(record->cid, order->cid, sizeof(record->cid));
+    memcpy(record->symbol, order->symbol, sizeof(record->symbol));
+}
+
+static uint64_t replay_records(matching_engine_t *me, journal_record_t *records, uint64_t length, uint64_t *last_oid)
+{
+    /* Helper function to match the records again in the same sequence. Matching is deterministic,
+       so the books end up in the same state as when the records were written. */
+    for (uint64_t i = 0; i < length; i++)
+    {
+        order_t *order = pool_alloc(&me->orders);
+        if (order == NULL)
+        {
+            return 1;
+        }
+
+        journal_record_t *record = &records[i];
+        order->oid = record->oid;
+        order->t_client = record->t_client;
+        order->t_server = record->t_server;
+        order->operation = record->operation;
+        order->price = record->price;
+        order->quantity = record->quantity;
+        order->target_oid = record->target_oid;
+        memcpy(order->cid, record->cid, sizeof(record->cid));
+        memcpy(order->symbol, record->symbol, sizeof(record->symbol));
+        if (order->operation <= 1)
+        {
+            order->symbol_id = intern_symbol(&me->symbols, order->symbol);
+        }
+
+        if (order->oid > *last_oid)
+        {
+            *last_oid = order->oid;
+        }
+
+        // Flag init=true avoids writing replayed orders to Redis and to the journal again
+        match_trade(me, order, true);
+    }
+
+    // Success
+    return 0;
+}
+
+static uint64_t write_all(int64_t fd, void *data, uint64_t length)
+{
+    /* Helper function to write the whole buffer to the file */
+    char *position = data;
+    while (length > 0)
+    {
+        ssize_t written = write(fd, position, length);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return 1;
+        }
+        position += written;
+        length -= written;
+    }
+
+    // Success
+    return 0;
+}
+
+static uint64_t write_snapshot(journal_t *journal, matching_engine_t *me)
+{
+    /* Helper function to write all resting orders of the books to the snapshot file. It runs in the forked process,
+       so it only reads the copy of the books and uses plain system calls: no locks, no allocations, no logs. */
+    int64_t fd = open(journal->snapshot_tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    // Header is written at the end, when the number of orders is known
+    journal_snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    if (lseek(fd, sizeof(header), SEEK_SET) < 0)
+    {
+        close(fd);
+        return 2;
+    }
+
+    // Orders are written in the queue sequence of each level, so that replay keeps their time priority
+    journal_record_t records[JOURNAL_SNAPSHOT_BATCH];
+    uint64_t batch = 0;
+    for (uint64_t i = 0; i < me->symbols.symbols; i++)
+    {
+        book_side_t *sides[2] = {&me->books[i].sell, &me->books[i].buy};
+        for (uint64_t j = 0; j < 2; j++)
+        {
+            for (uint64_t k = 0; k < sides[j]->depth; k++)
+            {
+                for (order_t *order = sides[j]->levels[k]->head; order != NULL; order = order->next)
+                {
+                    order_to_record(order, &records[batch]);
+                    batch++;
+                    header.orders++;
+                    if (batch == JOURNAL_SNAPSHOT_BATCH)
+                    {
+                        if (write_all(fd, records, sizeof(records)) != 0)
+                        {
+                            close(fd);
+                            return 3;
+                        }
+                        batch = 0;
+                    }
+                }
+            }
+        }
+    }
+    if (write_all(fd, records, batch * sizeof(journal_record_t)) != 0)
+    {
+        close(fd);
+        return 3;
+    }
+
+    // Books contain all journaled orders up to the moment of the fork. The header of the journal is shared with
+    // the parent, which keeps appending, so the length is the one taken before the fork.
+    memcpy(header.magic, JOURNAL_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.record_size = sizeof(journal_record_t);
+    header.journal_length = journal->snapshot_length;
+    if (header.journal_length > 0)
+    {
+        journal_record_t *records_journal = (journal_record_t *)(journal->map + sizeof(journal_header_t));
+        header.last_oid = records_journal[header.journal_length - 1].oid;
+    }
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header) || fsync(fd) != 0)
+    {
+        close(fd);
+        return 4;
+    }
+    close(fd);
+
+    // Replace the previous snapshot atomically, so there is always one complete snapshot on the disk
+    if (rename(journal->snapshot_tmp_path, journal->snapshot_path) != 0)
+    {
+        return 5;
+    }
+
+    // Success
+    return 0;
+}
+
+static bool reap_snapshot(journal_t *journal, bool is_blocking)
+{
+    /* Helper function to collect the result of the process writing the snapshot.
+       Returns false if the snapshot is still being written. */
+    int status;
+    pid_t pid = waitpid(journal->snapshot_pid, &status, is_blocking ? 0 : WNOHANG);
+    if (pid == 0)
+    {
+        return false;
+    }
+
+    if (pid == journal->snapshot_pid && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+    {
+        LOG_INFO("Snapshot of the books is written to %s", journal->snapshot_path);
+    }
+    else
+    {
+        LOG_ERROR("Unable to write snapshot of the books to %s", journal->snapshot_path);
+    }
+    journal->snapshot_pid = 0;
+
+    return true;
+}
+
+uint64_t open_journal(journal_t *journal, char *path)
+{
+    /* Helper function to open the existing journal or to create the new one */
+    if (snprintf(journal->snapshot_path, JOURNAL_PATH_LEN, "%s.snapshot", path) >= JOURNAL_PATH_LEN ||
+        snprintf(journal->snapshot_tmp_path, JOURNAL_PATH_LEN, "%s.snapshot.tmp", path) >= JOURNAL_PATH_LEN)
+    {
+        LOG_ERROR("Journal path %s is too long", path);
+        return 5;
+    }
+    journal->snapshot_length = 0;
+    journal->snapshot_pid = 0;
+
+    journal->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (journal->fd < 0)
+    {
+        perror("Error: Cannot open journal: ");
+        return 1;
+    }
+
+    struct stat journal_stat;
+    if (fstat(journal->fd, &journal_stat) != 0)
+    {
+        perror("Error: Cannot read journal size: ");
+        close(journal->fd);
+        return 2;
+    }
+
+    // Capacity is always whole chunks, so the new file gets the first chunk
+    uint64_t capacity = (uint64_t)journal_stat.st_size;
+    bool is_new = capacity == 0;
+    if (capacity % JOURNAL_CHUNK_SIZE != 0 || is_new)
+    {
+        capacity += JOURNAL_CHUNK_SIZE - capacity % JOURNAL_CHUNK_SIZE;
+    }
+
+    if (map_journal(journal, capacity) != 0)
+    {
+        close(journal->fd);
+        return 3;
+    }
+
+    if (is_new)
+    {
+        memcpy(journal->header->magic, JOURNAL_MAGIC, sizeof(journal->header->magic));
+        journal->header->record_size = sizeof(journal_record_t);
+        journal->header->length = 0;
+    }
+
+    // Refuse to append to the file, which is not the journal of this version
+    if (memcmp(journal->header->magic, JOURNAL_MAGIC, sizeof(journal->header->magic)) != 0 ||
+        journal->header->record_size != sizeof(journal_record_t) ||
+        sizeof(journal_header_t) + journal->header->length * sizeof(journal_record_t) > journal->capacity)
+    {
+        LOG_ERROR("%s is not a valid journal", path);
+        munmap(journal->map, journal->capacity);
+        close(journal->fd);
+        return 4;
+    }
+
+    // Success
+    return 0;
+}
+
+uint64_t append_journal(journal_t *journal, order_t *order)
+{
+    /* Helper function to append the order to the journal. The record is copied first and the length in the header
+       is updated after it, so the record is replayed only if it was written completely. */
+    uint64_t offset = sizeof(journal_header_t) + journal->header->length * sizeof(journal_record_t);
+    if (offset + sizeof(journal_record_t) > journal->capacity)
+    {
+        // Bigger mapping replaces the old one only when it exists, so the journal stays usable if growing fails
+        char *map = journal->map;
+        uint64_t capacity = journal->capacity;
+        if (map_journal(journal, capacity + JOURNAL_CHUNK_SIZE) != 0)
+        {
+            LOG_ERROR("Unable to grow journal to %lu bytes", capacity + JOURNAL_CHUNK_SIZE);
+            return 1;
+        }
+        munmap(map, capacity);
+    }
+
+    order_to_record(order, (journal_record_t *)(journal->map + offset));
+    journal->header->length++;
+
+    // Success
+    return 0;
+}
+
+uint64_t take_snapshot(journal_t *journal, matching_engine_t *me)
+{
+    /* Helper function to start writing the snapshot of the books from the forked process. The child gets
+       the copy-on-write view of the books at this moment, so matching continues while the snapshot is written. */
+    // Skip this snapshot, if the previous one is still being written, it is taken again with the next order
+    if (journal->snapshot_pid > 0 && !reap_snapshot(journal, false))
+    {
+        LOG_DEBUG("Previous snapshot is still being written, snapshot at order %lu is skipped", journal->header->length);
+        return 0;
+    }
+
+    // Length of the snapshot is set before the fork, so the child sees it, and it is kept only if the snapshot is started
+    uint64_t snapshot_length = journal->snapshot_length;
+    journal->snapshot_length = journal->header->length;
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        LOG_ERROR("Unable to fork the process for the snapshot of the books");
+        journal->snapshot_length = snapshot_length;
+        return 1;
+    }
+    if (pid == 0)
+    {
+        _exit(write_snapshot(journal, me));
+    }
+
+    LOG_INFO("Snapshot of the books at journaled order %lu is started", journal->header->length);
+    journal->snapshot_pid = pid;
+
+    // Success
+    return 0;
+}
+
+uint64_t load_snapshot(journal_t *journal, matching_engine_t *me, uint64_t *last_oid)
+{
+    /* Helper function to rebuild the books from the latest snapshot, if there is one.
+       The journal is replayed from the end of the snapshot afterwards, the broken snapshot is ignored. */
+    int64_t fd = open(journal->snapshot_path, O_RDONLY);
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    struct stat snapshot_stat;
+    journal_snapshot_header_t *header = MAP_FAILED;
+    if (fstat(fd, &snapshot_stat) == 0 && (uint64_t)snapshot_stat.st_size >= sizeof(journal_snapshot_header_t))
+    {
+        header = mmap(NULL, snapshot_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (header == MAP_FAILED ||
+        memcmp(header->magic, JOURNAL_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->record_size != sizeof(journal_record_t) ||
+        header->journal_length > journal->header->length ||
+        sizeof(journal_snapshot_header_t) + header->orders * sizeof(journal_record_t) != (uint64_t)snapshot_stat.st_size)
+    {
+        LOG_ERROR("Snapshot %s is not valid, the whole journal is replayed", journal->snapshot_path);
+        if (header != MAP_FAILED)
+        {
+            munmap(header, snapshot_stat.st_size);
+        }
+        return 0;
+    }
+
+    posix_madvise(header, snapshot_stat.st_size, POSIX_MADV_SEQUENTIAL);
+    uint64_t status = replay_records(me, (journal_record_t *)(header + 1), header->orders, last_oid);
+    if (header->last_oid > *last_oid)
+    {
+        *last_oid = header->last_oid;
+    }
+    journal->snapshot_length = header->journal_length;
+    LOG_INFO("Loaded snapshot of %lu orders at journaled order %lu", header->orders, header->journal_length);
+    munmap(header, snapshot_stat.st_size);
+
+    return status;
+}
+
+uint64_t replay_journal(journal_t *journal, matching_engine_t *me, uint64_t *last_oid)
+{
+    /* Helper function to rebuild the order books by matching journaled orders after the snapshot again */
+    posix_madvise(journal->map, journal->capacity, POSIX_MADV_SEQUENTIAL);
+    journal_record_t *records = (journal_record_t *)(journal->map + sizeof(journal_header_t));
+
+    return replay_records(me, records + journal->snapshot_length, journal->header->length - journal->snapshot_length, last_oid);
+}
+
+void close_journal(journal_t *journal)
+{
+    /* Helper function to write the journal to the disk and to close it */
+    if (journal->snapshot_pid > 0)
+    {
+        reap_snapshot(journal, true);
+    }
+    msync(journal->map, journal->capacity, MS_SYNC);
+    munmap(journal->map, journal->capacity);
+    close(journal->fd);
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+/* This file contains header for the append-only binary journal of the orders received by the matching engine
+   and for the periodic snapshots of the order books */
+
+// Preprocessor directives
+#include <stdint.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t open_journal(journal_t *journal, char *path);
+uint64_t append_journal(journal_t *journal, order_t *order);
+uint64_t take_snapshot(journal_t *journal, matching_engine_t *me);
+uint64_t load_snapshot(journal_t *journal, matching_engine_t *me, uint64_t *last_oid);
+uint64_t replay_journal(journal_t *journal, matching_engine_t *me, uint64_t *last_oid);
+void close_journal(journal_t *journal);
\ No newline at end of file
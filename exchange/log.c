@@ -0,0 +1,208 @@
+/* This file contains the logging: errors are printed synchronously, other levels are passed through
+   the bounded multi-producer ring buffer to the background thread, once it is started with `log_init()` */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+// Local headers
+#include "log.h"
+#include "helper.h"
+
+// Define data types
+typedef struct log_slot_t
+{
+    atomic_uint_fast64_t sequence;
+    char text[LOG_MSG_LEN];
+} log_slot_t;
+
+// Define ring buffer shared between producers and the background thread
+static log_slot_t log_ring[LOG_RING_SIZE];
+static atomic_uint_fast64_t log_tail;
+static uint64_t log_head;
+static atomic_uint_fast64_t log_dropped_count;
+static atomic_bool log_started;
+static atomic_bool log_stopping;
+static pthread_t log_thread;
+static uint64_t log_midnight;
+
+static const char *log_level_names[] = {"ERROR", "INFO", "DEBUG", "TRACE"};
+
+// Define aux functions
+static bool log_drain(void)
+{
+    /* Helper function to print all complete messages from the ring. Returns `true` if anything was printed. */
+    bool is_printed = false;
+
+    while (true)
+    {
+        log_slot_t *slot = &log_ring[log_head & (LOG_RING_SIZE - 1)];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != log_head + 1)
+        {
+            break;
+        }
+
+        fputs(slot->text, stdout);
+
+        // Release the slot for the next lap of producers
+        atomic_store_explicit(&slot->sequence, log_head + LOG_RING_SIZE, memory_order_release);
+        log_head++;
+        is_printed = true;
+    }
+
+    return is_printed;
+}
+
+static void log_report_dropped(uint64_t *reported)
+{
+    /* Helper function to print the number of messages dropped since the last report, if there are any.
+       It is printed directly, because the ring may be full again. */
+    uint64_t dropped = log_dropped();
+    if (dropped != *reported)
+    {
+        printf("%lu | %s | %lu log messages were dropped, the log ring is full\n",
+               get_time_nanoseconds_since_midnight(log_midnight),
+               log_level_names[LOG_LEVEL_ERROR],
+               dropped - *reported);
+        *reported = dropped;
+    }
+}
+
+static void *log_worker(void *arg)
+{
+    /* Background thread, which prints messages from the ring buffer */
+    (void)arg;
+    uint64_t reported = 0;
+    time_t t_reported = time(NULL);
+
+    while (!atomic_load(&log_stopping))
+    {
+        if (log_drain())
+        {
+            fflush(stdout);
+        }
+        else
+        {
+            nanosleep((const struct timespec[]){{0, 1000000L}}, NULL);
+        }
+
+        if (time(NULL) - t_reported >= LOG_DROPPED_INTERVAL)
+        {
+            log_report_dropped(&reported);
+            t_reported = time(NULL);
+        }
+    }
+
+    // Print what is left before exit
+    log_drain();
+    log_report_dropped(&reported);
+    fflush(stdout);
+
+    return NULL;
+}
+
+static void log_stop(void)
+{
+    /* Helper function to stop the background thread on exit, so that queued messages are not lost */
+    atomic_store(&log_stopping, true);
+    pthread_join(log_thread, NULL);
+}
+
+uint64_t log_init(void)
+{
+    /* Helper function to start the background thread. Until it is started all messages are printed synchronously. */
+    log_midnight = get_time_nanoseconds_midnight();
+
+    for (uint64_t i = 0; i < LOG_RING_SIZE; i++)
+    {
+        atomic_init(&log_ring[i].sequence, i);
+    }
+
+    if (pthread_create(&log_thread, NULL, log_worker, NULL) != 0)
+    {
+        perror("Error: Cannot start logging thread: ");
+        return 1;
+    }
+    atexit(log_stop);
+    atomic_store(&log_started, true);
+
+    // Success
+    return 0;
+}
+
+void log_write(uint64_t level, const char *format, ...)
+{
+    /* Helper function to format the message with timestamp and level and to print or queue it */
+    va_list args;
+
+    // Errors and messages before the start of the thread are printed immediately
+    if (level == LOG_LEVEL_ERROR || !atomic_load_explicit(&log_started, memory_order_relaxed))
+    {
+        if (log_midnight == 0)
+        {
+            log_midnight = get_time_nanoseconds_midnight();
+        }
+        printf("%lu | %s | ", get_time_nanoseconds_since_midnight(log_midnight), log_level_names[level]);
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+        printf("\n");
+        return;
+    }
+
+    // Reserve the slot in the ring
+    uint64_t pos = atomic_load_explicit(&log_tail, memory_order_relaxed);
+    log_slot_t *slot;
+    while (true)
+    {
+        slot = &log_ring[pos & (LOG_RING_SIZE - 1)];
+        int64_t diff = (int64_t)atomic_load_explicit(&slot->sequence, memory_order_acquire) - (int64_t)pos;
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&log_tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        // Ring is full, message is dropped rather than blocking the caller
+        else if (diff < 0)
+        {
+            atomic_fetch_add_explicit(&log_dropped_count, 1, memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&log_tail, memory_order_relaxed);
+        }
+    }
+
+    // Format message into the slot
+    int n = snprintf(slot->text, LOG_MSG_LEN, "%lu | %s | ",
+                     get_time_nanoseconds_since_midnight(log_midnight),
+                     log_level_names[level]);
+    va_start(args, format);
+    n += vsnprintf(slot->text + n, LOG_MSG_LEN - n - 1, format, args);
+    va_end(args);
+    if (n > LOG_MSG_LEN - 2)
+    {
+        n = LOG_MSG_LEN - 2;
+    }
+    slot->text[n] = '\n';
+    slot->text[n + 1] = '\0';
+
+    // Publish the slot to the background thread
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+}
+
+uint64_t log_dropped(void)
+{
+    /* Helper function to get the number of messages dropped because the ring was full */
+    return atomic_load(&log_dropped_count);
+}
\ No newline at end of file
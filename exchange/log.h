@@ -0,0 +1,44 @@
+/* This file contains header for the logging with compile-time log levels and asynchronous sink.
+   Levels above LOG_LEVEL are removed by compiler, so they cost nothing in production build.
+   Info level is formatted into lock-free ring buffer and printed by the background thread. */
+
+// Preprocessor directives
+#include <stdint.h>
+
+// Log levels
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_DEBUG 2
+#define LOG_LEVEL_TRACE 3
+
+// Compile-time log level, set with `-DLOG_LEVEL=...`
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Ring buffer data, size is power of two
+#define LOG_RING_SIZE 4096
+#define LOG_MSG_LEN 256
+
+// Dropped messages are reported not more often than the interval in seconds
+#define LOG_DROPPED_INTERVAL 1
+
+// Logging macros, disabled levels are still type-checked but never called
+#define LOG_AT_LEVEL(level, ...)             \
+    do                                       \
+    {                                        \
+        if (LOG_LEVEL >= (level))            \
+        {                                    \
+            log_write((level), __VA_ARGS__); \
+        }                                    \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT_LEVEL(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_TRACE(...) LOG_AT_LEVEL(LOG_LEVEL_TRACE, __VA_ARGS__)
+
+// Declare function prototypes
+uint64_t log_init(void);
+void log_write(uint64_t level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+uint64_t log_dropped(void);
\ No newline at end of file
@@ -1,10 +1,14 @@
 // Preprocessing
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
 #include <time.h>
+#include <errno.h>
+#include <byteswap.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -14,29 +18,263 @@
 // Local headers
 #include "helper.h"
 #include "comm.h"
+#include "serializers.h"
+#include "retransmit.h"
+#include "md_book.h"
+#include "md_directory.h"
+#include "md_publisher.h"
+
+// Define aux functions
+static uint64_t get_channel_addr(struct sockaddr_in *addr, server_t *server, uint64_t channel)
+{
+    /* Helper function to get the multicast group of the channel, channels take consecutive addresses from the group
+       of the first one and share its port */
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(server->port);
+    if (inet_pton(AF_INET, server->ip, &addr->sin_addr) <= 0)
+    {
+        return 1;
+    }
+    addr->sin_addr.s_addr = htonl(ntohl(addr->sin_addr.s_addr) + channel);
+
+    return 0;
+}
+
+static bool has_md_packets(md_publisher_t *publishers, uint64_t channels)
+{
+    /* Helper function to check if any channel has datagrams, which wait to be sent */
+    for (uint64_t i = 0; i < channels; i++)
+    {
+        if (publishers[i].packets > 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint64_t publish_book_event(md_publisher_t *publisher, book_event_t *event)
+{
+    /* Helper function to encode the book event directly into the datagram */
+    if (event->type == MD_EVENT_ADD)
+    {
+        md_add_order_message_t *message = (md_add_order_message_t *)get_md_message(publisher, sizeof(md_add_order_message_t));
+        if (message == NULL)
+        {
+            return 1;
+        }
+        message->type = MD_EVENT_ADD;
+        message->timestamp = bswap_64(event->t_server);
+        message->order_id = bswap_64(event->oid);
+        message->side = event->operation == 1 ? MD_SIDE_BUY : MD_SIDE_SELL;
+        message->shares = bswap_64(event->quantity);
+        memcpy(message->stock, event->symbol, SYMBOL_LEN);
+        message->price = bswap_64(event->price);
+    }
+    else if (event->type == MD_EVENT_EXECUTE)
+    {
+        md_order_executed_message_t *message = (md_order_executed_message_t *)get_md_message(publisher, sizeof(md_order_executed_message_t));
+        if (message == NULL)
+        {
+            return 1;
+        }
+        message->type = MD_EVENT_EXECUTE;
+        message->timestamp = bswap_64(event->t_server);
+        message->order_id = bswap_64(event->oid);
+        message->executed_shares = bswap_64(event->quantity);
+    }
+    else if (event->type == MD_EVENT_CANCEL)
+    {
+        md_order_cancel_message_t *message = (md_order_cancel_message_t *)get_md_message(publisher, sizeof(md_order_cancel_message_t));
+        if (message == NULL)
+        {
+            return 1;
+        }
+        message->type = MD_EVENT_CANCEL;
+        message->timestamp = bswap_64(event->t_server);
+        message->order_id = bswap_64(event->oid);
+        message->cancelled_shares = bswap_64(event->quantity);
+    }
+    else
+    {
+        printf("%lu: Unknown book event '%c' of order %lu, skipped\n", time(NULL), event->type, event->oid);
+    }
+
+    return 0;
+}
+
+static uint64_t publish_symbol_snapshot(md_publisher_t *snapshot, md_book_t *book, uint64_t symbol_id, uint64_t sequence,
+                                        uint64_t timestamp)
+{
+    /* Helper function to send all resting orders of the symbol as add order messages, from the best price of each side.
+       They follow the snapshot message, which tells the sequence number of the next delta, so the snapshot is the
+       state of the book just before that delta. */
+    order_book_t *order_book = &book->books[symbol_id];
+    book_side_t *sides[2] = {&order_book->buy, &order_book->sell};
+    uint64_t orders = 0;
+    for (uint64_t i = 0; i < 2; i++)
+    {
+        for (uint64_t j = 0; j < sides[i]->depth; j++)
+        {
+            orders += sides[i]->levels[j]->orders;
+        }
+    }
+
+    md_snapshot_message_t *message = (md_snapshot_message_t *)get_md_message(snapshot, sizeof(md_snapshot_message_t));
+    if (message == NULL)
+    {
+        return 1;
+    }
+    message->type = MD_EVENT_SNAPSHOT;
+    message->timestamp = bswap_64(timestamp);
+    memcpy(message->stock, book->symbols.names[symbol_id], SYMBOL_LEN);
+    message->sequence = bswap_64(sequence);
+    message->orders = bswap_64(orders);
+
+    // Resting orders are encoded the same way as in the deltas
+    for (uint64_t i = 0; i < 2; i++)
+    {
+        for (uint64_t j = sides[i]->depth; j > 0; j--)
+        {
+            for (order_t *order = sides[i]->levels[j - 1]->head; order != NULL; order = order->next)
+            {
+                book_event_t event;
+                event.type = MD_EVENT_ADD;
+                event.oid = order->oid;
+                memcpy(event.symbol, book->symbols.names[symbol_id], sizeof(event.symbol));
+                event.operation = order->operation;
+                event.price = order->price;
+                event.quantity = order->quantity;
+                event.t_server = order->t_server;
+                if (publish_book_event(snapshot, &event) != 0)
+                {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return flush_md_packets(snapshot);
+}
+
+static uint64_t publish_symbol_quote(md_publisher_t *qbbo, md_book_t *book, uint64_t symbol_id, uint64_t timestamp)
+{
+    /* Helper function to add the quote message with the last best bid and offer taken from the book of the symbol */
+    md_quote_message_t *message = (md_quote_message_t *)get_md_message(qbbo, sizeof(md_quote_message_t));
+    if (message == NULL)
+    {
+        return 1;
+    }
+    message->type = MD_EVENT_QUOTE;
+    message->timestamp = bswap_64(timestamp);
+    memcpy(message->stock, book->symbols.names[symbol_id], SYMBOL_LEN);
+    message->bid_price = bswap_64(book->quotes[symbol_id].bid_price);
+    message->bid_size = bswap_64(book->quotes[symbol_id].bid_size);
+    message->ask_price = bswap_64(book->quotes[symbol_id].ask_price);
+    message->ask_size = bswap_64(book->quotes[symbol_id].ask_size);
+
+    return 0;
+}
+
+static uint64_t publish_changed_quotes(md_publisher_t *qbbo, md_book_t *book, uint64_t timestamp)
+{
+    /* Helper function to send the quotes of the symbols, which books changed since the last call. Each symbol is sent
+       once with its latest quote, changes, which didn't move the best bid and offer, aren't sent. */
+    for (uint64_t i = 0; i < book->changed; i++)
+    {
+        uint64_t symbol_id = book->changed_symbols[i];
+        book->is_changed[symbol_id] = false;
+        if (update_md_quote(book, symbol_id) && publish_symbol_quote(qbbo, book, symbol_id, timestamp) != 0)
+        {
+            return 1;
+        }
+    }
+    book->changed = 0;
+
+    return qbbo->packets > 0 ? flush_md_packets(qbbo) : 0;
+}
 
 // Main function
-int main(int argc, char *argv[])
+int main(void)
 {
-    /* This is a main script for info server, which sends multicast feed every so often:
+    /* This is a main script for info server, which sends multicast feed of book deltas (add, execute and cancel
+       of the resting orders) as soon as the matching engine publishes them:
 
       Possible parameters:
       - multicast group IPv4 address
       - UDP port for application
-      - Sleep time between messages
+      - EXCHANGE_MD_MAX_DELAY_US: how long the partial datagram may wait for more messages during bursts
+      - IPv4 address and TCP port of the retransmission service, which sends lost messages again
+      - multicast group IPv4 address and UDP port of the snapshot channel
+      - EXCHANGE_MD_SNAPSHOT_INTERVAL_US: how often the book of the next symbol is sent on the snapshot channel
+      - EXCHANGE_MD_CHANNELS: number of channels the symbols are sharded across, channel `i` is sent to the multicast
+        groups `i` addresses after the configured ones and its retransmission service listens on the port `i` after
+        the configured one
+      - IPv4 address and TCP port of the directory, which tells clients the channels of their symbols
+      - multicast group IPv4 address and UDP port of the QBBO channel
+      - EXCHANGE_MD_QBBO_INTERVAL_US: how often the quotes of the symbols, which changed, are sent on the QBBO channel
     */
 
-    // Initialize message buffer
-    char server_message[MAX_MSG_LEN], client_message[MAX_MSG_LEN];
-    memset(server_message, '\0', sizeof(server_message));
-    memset(client_message, '\0', sizeof(client_message));
-
     // Get connection details
     server_t *addr_mcast = get_server("EXCHANGE_TAPE_IP", "EXCHANGE_TAPE_PORT", EXCHANGE_MCAST_PROTOCOL);
     server_t *addr_redis = get_server("REDIS_IP", "REDIS_PORT", IPPROTO_TCP);
     server_t *addr_mcast_source = get_server("EXCHANGE_TAPE_SOURCE_IP", "EXCHANGE_TAPE_PORT", EXCHANGE_MCAST_PROTOCOL);
+    server_t *addr_rewind = get_server("EXCHANGE_TAPE_REWIND_IP", "EXCHANGE_TAPE_REWIND_PORT", IPPROTO_TCP);
+    server_t *addr_snapshot = get_server("EXCHANGE_TAPE_SNAPSHOT_IP", "EXCHANGE_TAPE_SNAPSHOT_PORT", EXCHANGE_MCAST_PROTOCOL);
+    server_t *addr_directory = get_server("EXCHANGE_TAPE_DIRECTORY_IP", "EXCHANGE_TAPE_DIRECTORY_PORT", IPPROTO_TCP);
+    server_t *addr_qbbo = get_server("EXCHANGE_TAPE_QBBO_IP", "EXCHANGE_TAPE_QBBO_PORT", EXCHANGE_MCAST_PROTOCOL);
+
+    // Symbols are sharded across the channels, so that clients receive only the channels of their symbols
+    uint64_t channels = MD_CHANNELS;
+    char *channels_env = getenv("EXCHANGE_MD_CHANNELS");
+    if (channels_env != NULL)
+    {
+        channels = strtoul(channels_env, NULL, 10);
+    }
+    if (channels == 0 || channels > MD_MAX_CHANNELS)
+    {
+        printf("%lu: Error: Number of channels has to be from 1 to %d\n", time(NULL), MD_MAX_CHANNELS);
+        return 14;
+    }
+
+    // Each channel has its own publisher, which keeps the batch of datagrams, and its own publisher of snapshots
+    md_publisher_t *publishers = calloc(channels, sizeof(md_publisher_t));
+    md_publisher_t *snapshots = calloc(channels, sizeof(md_publisher_t));
+    md_retransmit_t *retransmits = calloc(channels, sizeof(md_retransmit_t));
+    if (publishers == NULL || snapshots == NULL || retransmits == NULL)
+    {
+        perror("Error: Cannot allocate memory: ");
+        return 15;
+    }
+
+    uint64_t max_delay = MD_MAX_DELAY_US;
+    char *max_delay_env = getenv("EXCHANGE_MD_MAX_DELAY_US");
+    if (max_delay_env != NULL)
+    {
+        max_delay = strtoul(max_delay_env, NULL, 10);
+    }
+
+    uint64_t snapshot_interval = MD_SNAPSHOT_INTERVAL_US;
+    char *snapshot_interval_env = getenv("EXCHANGE_MD_SNAPSHOT_INTERVAL_US");
+    if (snapshot_interval_env != NULL)
+    {
+        snapshot_interval = strtoul(snapshot_interval_env, NULL, 10);
+    }
+
+    uint64_t qbbo_interval = MD_QBBO_INTERVAL_US;
+    char *qbbo_interval_env = getenv("EXCHANGE_MD_QBBO_INTERVAL_US");
+    if (qbbo_interval_env != NULL)
+    {
+        qbbo_interval = strtoul(qbbo_interval_env, NULL, 10);
+    }
+
+    // Session is named by the start time, so that clients can tell the restarted feed by it
+    char session[MD_SESSION_LEN + 1];
+    snprintf(session, sizeof(session), "%010lu", (uint64_t)time(NULL));
 
-    // Initialize socket
+    // Initialize socket, all channels are sent from it
     int64_t sd = socket(AF_INET, SOCK_DGRAM, addr_mcast->protocol);
     if (sd < 0)
     {
@@ -55,16 +293,66 @@ int main(int argc, char *argv[])
         return 12;
     }
 
-    // Initialize server address (Destination IP and port)
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(addr_mcast->port);
-    if (inet_pton(AF_INET, addr_mcast->ip, &server_addr.sin_addr) < 0)
+    static md_directory_t directory;
+    directory.channels = channels;
+    memcpy(directory.session, session, MD_SESSION_LEN);
+    for (uint64_t i = 0; i < channels; i++)
+    {
+        // Initialize server address (Destination IP and port) of the deltas and of the snapshots
+        publishers[i].sd = sd;
+        publishers[i].sequence = 1;
+        publishers[i].max_delay = max_delay;
+        memcpy(publishers[i].session, session, MD_SESSION_LEN);
+        snapshots[i].sd = sd;
+        snapshots[i].sequence = 1;
+        snapshots[i].max_delay = snapshot_interval;
+        memcpy(snapshots[i].session, session, MD_SESSION_LEN);
+        if (get_channel_addr(&publishers[i].addr, addr_mcast, i) != 0 ||
+            get_channel_addr(&snapshots[i].addr, addr_snapshot, i) != 0)
+        {
+            perror("Error: Uncompatible IP Address: ");
+            return 12;
+        }
+
+        // Start retransmission service, it serves the messages of this session and channel only. Snapshots have
+        // the same session, but their own sequence numbers and they are not retransmitted.
+        server_t addr_channel_rewind = *addr_rewind;
+        addr_channel_rewind.port += i;
+        if (start_retransmit(&retransmits[i], &addr_channel_rewind, session) != 0)
+        {
+            return 13;
+        }
+        publishers[i].retransmit = &retransmits[i];
+
+        directory.groups[i] = publishers[i].addr;
+        directory.snapshot_groups[i] = snapshots[i].addr;
+        directory.rewind_ports[i] = addr_channel_rewind.port;
+    }
+    // Quotes of all symbols are sent on one channel, they are conflated, so they are not retransmitted
+    static md_publisher_t qbbo;
+    qbbo.sd = sd;
+    qbbo.sequence = 1;
+    qbbo.max_delay = qbbo_interval;
+    memcpy(qbbo.session, session, MD_SESSION_LEN);
+    if (get_channel_addr(&qbbo.addr, addr_qbbo, 0) != 0)
     {
         perror("Error: Uncompatible IP Address: ");
+        return 12;
     }
 
+    printf("%lu: Retransmission service started at %s @ %lu-%lu\n",
+           time(NULL),
+           addr_rewind->ip,
+           addr_rewind->port,
+           addr_rewind->port + channels - 1);
+
+    // Start directory, it doesn't change during the session
+    if (start_directory(&directory, addr_directory) != 0)
+    {
+        return 17;
+    }
+    printf("%lu: Directory of %lu channels started at %s @ %lu\n", time(NULL), channels, addr_directory->ip, addr_directory->port);
+
     // Open connection to Redis
     redisContext *red_con = redisConnect(addr_redis->ip, addr_redis->port);
     if (red_con != NULL && red_con->err)
@@ -74,15 +362,36 @@ int main(int argc, char *argv[])
     }
     printf("%lu: Connected to Redis\n", time(NULL));
 
-    // Initialize msg coounter
-    uint64_t msg_counter = 0;
+    // Events after the last one in the stream are read, after the books are loaded. Events, which happen during
+    // the load, are applied again, which doesn't change the books.
+    char last_id[REDIS_STREAM_ID_LEN] = "0-0";
+    redisReply *red_reply = redisCommand(red_con, "XREVRANGE %s + - COUNT 1", REDIS_EXCHANGE_BOOK_STREAM);
+    if (red_reply != NULL && red_reply->type == REDIS_REPLY_ARRAY && red_reply->elements == 1)
+    {
+        strncpy(last_id, red_reply->element[0]->element[0]->str, REDIS_STREAM_ID_LEN - 1);
+    }
+    freeReplyObject(red_reply);
+
+    // Load the books, which are sent on the snapshot channels
+    static md_book_t book;
+    if (init_md_book(&book) != 0)
+    {
+        return 18;
+    }
+    printf("%lu: %lu resting orders are loaded\n", time(NULL), load_md_book(&book, red_con));
 
     // Start loop for generating and sending messages
     printf("EXECHANGE IS OPENED! TRADING STARTED!\n");
-    printf("Sending data at %s @ %lu/%lu\n",
+    printf("Sending data of %lu channels at %s @ %lu/%lu in session %s, snapshots at %s @ %lu, quotes at %s @ %lu\n",
+           channels,
            addr_mcast->ip,
            addr_mcast->port,
-           addr_mcast->protocol);
+           addr_mcast->protocol,
+           session,
+           addr_snapshot->ip,
+           addr_snapshot->port,
+           addr_qbbo->ip,
+           addr_qbbo->port);
 
     // Get timestamp for the midnight
     int64_t time_midnight = get_time_nanoseconds_midnight();
@@ -92,79 +401,128 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // Announce the start of messages on every channel
+    for (uint64_t i = 0; i < channels; i++)
+    {
+        if (publish_system_event(&publishers[i], MD_SYSTEM_START, get_time_nanoseconds_since_midnight(time_midnight)) != 0 ||
+            flush_md_packets(&publishers[i]) != 0)
+        {
+            printf("%lu: Start of messages isn't sent on channel %lu\n", time(NULL), i);
+        }
+    }
+
+    // Snapshot of the next symbol is sent every interval, also while there are no events
+    uint64_t t_snapshot = get_time_microseconds();
+    uint64_t t_qbbo = t_snapshot;
+    uint64_t block = (snapshot_interval < qbbo_interval ? snapshot_interval : qbbo_interval) / 1000;
+    block = block > 0 ? block : 1;
+
     // Server execution loop
     while (true)
     {
-        // Prepare message
-        char *msg = calloc(MAX_MSG_LEN, sizeof(char));
-
-        // Read from Redis
-        redisReply *red_reply;
-        red_reply = redisCommand(red_con, "HKEYS %s", REDIS_EXCHANGE_A_ORDERS);
-        if (red_reply->elements == 0)
+        // Wait for book events until the next snapshot, unless there are datagrams to send, then only take
+        // what is already published
+        if (!has_md_packets(publishers, channels))
         {
-            sprintf(msg, "%lu:%lu:;", msg_counter, get_time_nanoseconds_since_midnight(time_midnight));
+            red_reply = redisCommand(red_con, "XREAD COUNT %d BLOCK %lu STREAMS %s %s",
+                                     REDIS_BOOK_READ_COUNT,
+                                     block,
+                                     REDIS_EXCHANGE_BOOK_STREAM,
+                                     last_id);
         }
         else
         {
-            sprintf(msg, "%lu:%lu:", msg_counter, get_time_nanoseconds_since_midnight(time_midnight));
-            for (uint64_t i = 0; i < red_reply->elements; i++)
-            {
-                redisReply *redis_reply_order = redisCommand(red_con, "HVALS %s:%s", REDIS_EXCHANGE_ORDER_PREFIX, red_reply->element[i]->str);
+            red_reply = redisCommand(red_con, "XREAD COUNT %d STREAMS %s %s",
+                                     REDIS_BOOK_READ_COUNT,
+                                     REDIS_EXCHANGE_BOOK_STREAM,
+                                     last_id);
+        }
+        if (red_reply == NULL || red_reply->type == REDIS_REPLY_ERROR)
+        {
+            printf("%lu: Error: Unable to read book events from Redis: %s\n",
+                   time(NULL),
+                   red_reply == NULL ? red_con->errstr : red_reply->str);
+            return 16;
+        }
 
-                // Append order id
-                strncat(msg, red_reply->element[i]->str, strlen(red_reply->element[i]->str));
-                strncat(msg, "/", 1);
+        // Reply contains one stream with the list of entries, the cost of each is the same regardless of the size of the book
+        uint64_t events = 0;
+        if (red_reply->type == REDIS_REPLY_ARRAY && red_reply->elements == 1)
+        {
+            redisReply *entries = red_reply->element[0]->element[1];
+            events = entries->elements;
+            for (uint64_t i = 0; i < entries->elements; i++)
+            {
+                strncpy(last_id, entries->element[i]->element[0]->str, REDIS_STREAM_ID_LEN - 1);
 
-                // Add order details to the message if provided
-                if (redis_reply_order->elements == 7)
+                // Every event carries the symbol of the order, so it is sent on the channel of the symbol
+                book_event_t event;
+                if (deserialize_book_event_redis(entries->element[i], &event) != 0)
+                {
+                    printf("%lu: Book event %s is corrupted, skipped\n", time(NULL), last_id);
+                }
+                else
                 {
-                    for (uint64_t j = 3; j < redis_reply_order->elements; j++)
+                    // Failed batch is dropped and recovered by retransmission, the books are kept up to date anyway
+                    if (publish_book_event(&publishers[get_symbol_channel(event.symbol, channels)], &event) != 0)
+                    {
+                        printf("%lu: Book event %s isn't published\n", time(NULL), last_id);
+                    }
+                    if (apply_book_event(&book, &event) != 0)
                     {
-                        strncat(msg, redis_reply_order->element[j]->str, strlen(redis_reply_order->element[j]->str));
-
-                        // Add delimiter
-                        if (j < redis_reply_order->elements - 1)
-                        {
-                            strncat(msg, "/", 1);
-                        }
-                        else
-                        {
-                            strncat(msg, ":", 1);
-                        }
+                        printf("%lu: Book event %s can't be applied to the books\n", time(NULL), last_id);
                     }
                 }
-
-                freeReplyObject(redis_reply_order);
             }
-
-            // Add end of the message delimiter
-            strcat(msg, ";");
         }
         freeReplyObject(red_reply);
 
-        // Send multicast message to the exchange clients
-        if (sendto(sd, msg, strlen(msg), 0, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+        // Stream is drained, so waiting for more doesn't fill the datagram, otherwise the partial datagram waits
+        // during the burst until it is full or the latency bound is reached
+        for (uint64_t i = 0; i < channels; i++)
         {
-            printf("%lu: Unable to send multicast message\n", time(NULL));
-            return 11;
+            if (publishers[i].packets > 0 &&
+                (events < REDIS_BOOK_READ_COUNT || get_time_microseconds() - publishers[i].t_open >= publishers[i].max_delay) &&
+                flush_md_packets(&publishers[i]) != 0)
+            {
+                printf("%lu: Deltas of channel %lu are left for retransmission\n", time(NULL), i);
+            }
         }
 
-        // Debug message test
-        printf("Outgoing message: %s\n", msg);
-
-        // Cleanup
-        free(msg);
+        // Quotes are conflated, the symbol, which changed many times during the interval, is sent once
+        if (get_time_microseconds() - t_qbbo >= qbbo_interval)
+        {
+            // Lost quotes aren't retransmitted, the next change or the refresh with the snapshot sends them again
+            if (publish_changed_quotes(&qbbo, &book, get_time_nanoseconds_since_midnight(time_midnight)) != 0)
+            {
+                printf("%lu: Quotes aren't sent\n", time(NULL));
+            }
+            t_qbbo = get_time_microseconds();
+        }
 
-        // Increase counter
-        msg_counter++;
+        // Deltas are sent before the snapshot, so that clients usually have them when the snapshot arrives
+        if (book.symbols.symbols > 0 && get_time_microseconds() - t_snapshot >= snapshot_interval)
+        {
+            uint64_t channel = get_symbol_channel(book.symbols.names[book.next_symbol], channels);
+            if ((publishers[channel].packets > 0 && flush_md_packets(&publishers[channel]) != 0) ||
+                publish_symbol_snapshot(&snapshots[channel], &book, book.next_symbol, publishers[channel].sequence,
+                                        get_time_nanoseconds_since_midnight(time_midnight)) != 0)
+            {
+                printf("%lu: Snapshot of '%s' isn't sent\n", time(NULL), book.symbols.names[book.next_symbol]);
+            }
 
-        // Delay till next execution
-        sleep(1);
+            // Quote of the symbol is sent again, so that clients, which joined late, get the quotes of quiet symbols
+            if (!book.is_changed[book.next_symbol] &&
+                (publish_symbol_quote(&qbbo, &book, book.next_symbol, get_time_nanoseconds_since_midnight(time_midnight)) != 0 ||
+                 flush_md_packets(&qbbo) != 0))
+            {
+                printf("%lu: Quote of '%s' isn't sent\n", time(NULL), book.symbols.names[book.next_symbol]);
+            }
+            book.next_symbol = (book.next_symbol + 1) % book.symbols.symbols;
+            t_snapshot = get_time_microseconds();
+        }
     }
 
-    // printf("Server's response: %s\n", server_message);
-
     // Close the socket
     close(sd);
 
@@ -172,9 +530,17 @@ int main(int argc, char *argv[])
     redisFree(red_con);
 
     // Clean up
+    free(publishers);
+    free(snapshots);
+    free(retransmits);
     free(addr_mcast);
     free(addr_redis);
+    free(addr_mcast_source);
+    free(addr_rewind);
+    free(addr_snapshot);
+    free(addr_directory);
+    free(addr_qbbo);
 
     // Return success
     return 0;
-}
+}
\ No newline at end of file
@@ -1,514 +1,426 @@
-/* This file contains header for the code of building and matching trading trie */
+/* This file contains the code of building and matching order books of the matching engine */
 
 // Preprocessor directives
-#include <hiredis/hiredis.h>
-#include <ctype.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <time.h>
 
 // Local headers
 #include "matching_engine.h"
+#include "order_book.h"
+#include "order_index.h"
+#include "pool.h"
+#include "persistence.h"
+#include "journal.h"
+#include "md_publisher.h"
 #include "helper.h"
+#include "log.h"
 
 // Define aux functions
-trading_trie_t *add_node_to_trie(char symbol)
+static book_side_t *get_order_side(matching_engine_t *me, order_t *order)
 {
-    /* Helper function to initialize trie */
-    trading_trie_t *tt = (trading_trie_t *)malloc(sizeof(trading_trie_t));
-    if (tt == NULL)
+    /* Helper function to get the side of the book, where the resting order is queued */
+    order_book_t *book = &me->books[order->symbol_id];
+    return order->operation == 1 ? &book->buy : &book->sell;
+}
+
+static order_t *find_own_order(matching_engine_t *me, order_t *request)
+{
+    /* Helper function to find the resting order to cancel or replace. Customers can modify only their own orders. */
+    order_t *order = find_order_in_index(&me->index, request->target_oid);
+    if (order == NULL)
     {
-        printf("%lu: Unable to allocate memory for trading trie\n", time(NULL));
+        LOG_INFO("Order %lu is not in the book, request %lu is rejected", request->target_oid, request->oid);
         return NULL;
     }
-
-    // initialize next nodes
-    for (int i = 0; i < N; i++)
+    if (strncmp(order->cid, request->cid, sizeof(order->cid)) != 0)
     {
-        tt->next[i] = NULL;
+        LOG_INFO("Order %lu doesn't belong to '%s', request %lu is rejected", order->oid, request->cid, request->oid);
+        return NULL;
     }
 
-    // initialize pointers to orders
-    tt->sell_head = NULL;
-    tt->sell_tail = NULL;
-    tt->buy_head = NULL;
-    tt->buy_tail = NULL;
+    return order;
+}
 
-    // initialize symbol
-    tt->symbol = symbol;
+static void persist_order(matching_engine_t *me, uint64_t type, order_t *order)
+{
+    /* Helper function to publish the change of the order to the persistence thread */
+    if (me->persistence == NULL)
+    {
+        return;
+    }
 
-    // return pointer to the trie
-    return tt;
+    persistence_event_t event;
+    event.type = type;
+    event.order = *order;
+    persist_event(me->persistence, &event);
 }
 
-void match_trade(trading_trie_t *tt, order_t *order, redisContext *red_con, bool init)
+static void cancel_order(matching_engine_t *me, order_t *order, bool init)
 {
-    /* Helper function which either builds or matches the entrie in trie*/
-
-    // Create a new pointer to tree for dynamic navigation
-    trading_trie_t *tt_ptr = tt;
+    /* Helper function to remove the resting order from the book, the index and Redis */
+    remove_order_from_book(get_order_side(me, order), order);
+    remove_order_from_index(&me->index, order->oid);
+    if (!init)
+    {
+        persist_order(me, PERSIST_CANCEL, order);
+    }
+    pool_free(&me->orders, order);
+}
 
-    // Initialize executed orders list
-    order_t *executed_orders = calloc(1, sizeof(order_t));
+matching_engine_t *create_matching_engine(void)
+{
+    /* Helper function to initialize matching engine with empty symbol directory and order books */
+    matching_engine_t *me = calloc(1, sizeof(matching_engine_t));
+    if (me == NULL)
+    {
+        LOG_ERROR("Unable to allocate memory for matching engine");
+        return NULL;
+    }
 
-    // Define flag that will indicate if the order was matched
-    bool is_matched = false;
+    // initialize pools for orders, executions and price levels
+    if (init_pool(&me->orders, sizeof(order_t), POOL_ORDERS_SLAB) != 0 ||
+        init_pool(&me->executions, sizeof(execution_t), POOL_EXECUTIONS_SLAB) != 0 ||
+        init_pool(&me->levels, sizeof(price_level_t), POOL_LEVELS_SLAB) != 0 ||
+        init_order_index(&me->index, ORDER_INDEX_INITIAL_CAPACITY) != 0)
+    {
+        free_matching_engine(me);
+        return NULL;
+    }
 
-    // Go through the trie to find the symbol or to create one
-    int i = 0;
-    while (order->symbol[i] != '\0')
+    // initialize order books
+    for (uint64_t i = 0; i < MAX_SYMBOLS; i++)
     {
-        // Normalize char to upper case
-        order->symbol[i] = toupper(order->symbol[i]);
+        init_book_side(&me->books[i].sell, 0, &me->levels);
+        init_book_side(&me->books[i].buy, 1, &me->levels);
+    }
+
+    // return pointer to the matching engine
+    return me;
+}
 
-        // Check if the next node exists and create if that is not
-        if (tt_ptr->next[order->symbol[i] - 'A'] == NULL)
+void match_trade(matching_engine_t *me, order_t *order, bool init)
+{
+    /* Helper function which either builds or matches the entrie in the order book of the symbol.
+       Symbol must be already resolved to `symbol_id` in the symbol directory.
+       Order must be allocated from the orders pool of the engine, which takes ownership of it. */
+
+    // Journal the order before it is matched, so that replaying the journal rebuilds the same books
+    if (!init && me->journal != NULL)
+    {
+        // Books contain all journaled orders at this point, so the snapshot taken now is consistent with the journal
+        if (me->journal->header->length - me->journal->snapshot_length >= JOURNAL_SNAPSHOT_INTERVAL)
         {
-            tt_ptr->next[order->symbol[i] - 'A'] = add_node_to_trie(order->symbol[i]);
+            take_snapshot(me->journal, me);
         }
-        // If exits, move to the next node
-        tt_ptr = tt_ptr->next[order->symbol[i] - 'A'];
 
-        i++;
+        if (append_journal(me->journal, order) != 0)
+        {
+            LOG_ERROR("Unable to journal order %lu", order->oid);
+        }
     }
 
-    // When we got to the leaf (final symbol), check if there are already orders to match
-    // For buy operation
-    if (order->operation == 1)
+    // Initialize executed orders list, which keeps executions in the order of fills
+    execution_t *executions = NULL;
+    execution_t *executions_tail = NULL;
+
+    // For cancel and replace operations, the resting order is found by its id in O(1)
+    if (order->operation == 2 || order->operation == 3)
     {
-        printf("%lu: Buy order from '%s' for '%s' with price '%f' and quantity '%lu'\n",
-               time(NULL),
-               order->cid,
-               order->symbol,
-               order->price,
-               order->quantity);
-        // Check if there are any sell orders
-        if (tt_ptr->sell_head != NULL)
+        order_t *resting_order = find_own_order(me, order);
+        if (resting_order == NULL)
         {
-            printf("%lu: Looking for existing orders in the sell queue for '%s' ...\n", time(NULL), order->symbol);
-
-            // Loop through the sell orders
-            order_t *sell_order = tt_ptr->sell_head;
-            while (sell_order != NULL && !is_matched)
-            {
-                printf("%lu: There are orders in the sell queue for '%s'! Checking them...\n", time(NULL), order->symbol);
-                printf("%lu: Sell order from '%s' for '%s' with price '%.2f' and quantity '%lu'\n",
-                       time(NULL),
-                       sell_order->cid,
-                       sell_order->symbol,
-                       sell_order->price,
-                       sell_order->quantity);
-
-                // Check if the buy price is higher or equal to the sell price
-                if (order->price >= sell_order->price)
-                {
-                    printf("%lu: Buy price '%.2f' is higher than or equal to the sell price '%.2f', checking quantity...\n",
-                           time(NULL),
-                           order->price,
-                           sell_order->price);
-                    // Check if the buy quantity is equal to the sell quantity
-                    if (order->quantity == sell_order->quantity)
-                    {
-                        printf("%lu: Buy quantity %lu equals to sell quantity %lu. Order is matched!\n",
-                               time(NULL),
-                               order->quantity,
-                               sell_order->quantity);
-
-                        // Remove from the sell list
-                        // Relinking the right part of the node
-                        if (sell_order->next != NULL)
-                        {
-                            sell_order->next->previous = sell_order->previous;
-                        }
-                        else
-                        {
-                            tt_ptr->sell_tail = sell_order->previous;
-                        }
-
-                        // Relinking the left part of the node
-                        if (sell_order->previous != NULL)
-                        {
-                            sell_order->previous->next = sell_order->next;
-                        }
-                        else
-                        {
-                            tt_ptr->sell_head = sell_order->next;
-                        }
-
-                        // Adjust the price for more prefferable one (i.e, sell more expensive)
-                        if (order->price > sell_order->price)
-                        {
-                            sell_order->price = order->price;
-                        }
-
-                        // Add to the executed orders list
-                        order_t *temp = executed_orders;
-                        executed_orders = sell_order;
-                        executed_orders->next = temp;
-                        executed_orders->previous = NULL;
-
-                        // Move the buy order to the list of the executed orders
-                        temp = executed_orders;
-                        executed_orders = order;
-                        executed_orders->next = temp;
-                        executed_orders->previous = NULL;
-
-                        // Communicate that order is mathced
-                        is_matched = true;
-                    }
-                    // If the quantity is not equal, move to the next sell order
-                    else
-                    {
-                        printf("%lu: Buy quantity %lu doesn't equal sell quantity %lu, moving to the next sell order.\n",
-                               time(NULL),
-                               order->quantity,
-                               sell_order->quantity);
-
-                        sell_order = sell_order->next;
-                    }
-                }
-                // If the buy price is lower than the sell price, move to the next sell order
-                else
-                {
-                    printf("%lu: Buy price '%.2f' is lower than the sell price '%.2f', moving to the next sell order.\n",
-                           time(NULL),
-                           order->price,
-                           sell_order->price);
-
-                    sell_order = sell_order->next;
-                }
-            }
+            pool_free(&me->orders, order);
+            return;
+        }
 
-            // If order is not matched, add it to the buy list
-            if (!is_matched)
+        // Cancel
+        if (order->operation == 2)
+        {
+            if (!init)
             {
-                printf("%lu: There are no matching buy orders for by of '%s' of '%lu' at '%.2f'. Adding to the queue...\n",
-                       time(NULL),
-                       order->symbol,
-                       order->quantity,
-                       order->price);
-
-                // Add to the begining of the list if there are no orders
-                if (tt_ptr->buy_head == NULL)
-                {
-                    tt_ptr->buy_head = order;
-                    tt_ptr->buy_tail = order;
-
-                    printf("%lu: Order is added to the beginning of the buy queue for '%s'...\n", time(NULL), order->symbol);
-                }
-                // Add to the end, if there are orders
-                else
-                {
-                    tt_ptr->buy_tail->next = order;
-                    tt_ptr->buy_tail = order;
-
-                    printf("%lu: Order is added to the end of the buy queue for '%s'...\n", time(NULL), order->symbol);
-                }
-
-                // Add to Redis
-                if (!init)
-                {
-                    uint64_t add_redis_status = add_order_to_redis(red_con, order);
-                    printf("%lu: Order is added to Redis with status '%lu'\n", time(NULL), add_redis_status);
-                }
+                LOG_INFO("Order %lu is cancelled", resting_order->oid);
             }
+            cancel_order(me, resting_order, init);
+            pool_free(&me->orders, order);
+            return;
         }
-        // If there are no orders to match, add order to the trie
-        else
+
+        // Replacement is the new order for the same symbol and side
+        if (order->quantity == 0 || order->price == 0)
         {
-            printf("%lu: There are no orders in the sell queue for '%s', adding to the buy queue...\n", time(NULL), order->symbol);
+            LOG_ERROR("Replacement %lu of order %lu has no quantity or price", order->oid, resting_order->oid);
+            pool_free(&me->orders, order);
+            return;
+        }
+        memcpy(order->symbol, resting_order->symbol, sizeof(order->symbol));
+        order->symbol_id = resting_order->symbol_id;
+        order->operation = resting_order->operation;
 
-            // Add to the begining of the list if there are no orders
-            if (tt_ptr->buy_head == NULL)
+        // Replacement at the same price with not bigger quantity keeps the time priority. It takes the time of
+        // the resting order, so that the books loaded from Redis and the market data queue it at the same place.
+        if (order->price == resting_order->price && order->quantity <= resting_order->quantity)
+        {
+            if (!init)
             {
-                tt_ptr->buy_head = order;
-                tt_ptr->buy_tail = order;
-
-                printf("%lu: Order is added to the beginning of the buy queue for '%s'...\n", time(NULL), order->symbol);
+                LOG_INFO("Order %lu is replaced with order %lu in the queue", resting_order->oid, order->oid);
             }
-            // Add to the end, if there are orders
-            else
+            order->t_server = resting_order->t_server;
+            replace_order_in_book(resting_order, order);
+            remove_order_from_index(&me->index, resting_order->oid);
+            if (add_order_to_index(&me->index, order) != 0)
             {
-                tt_ptr->buy_tail->next = order;
-                tt_ptr->buy_tail = order;
-
-                printf("%lu: Order is added to the end of the buy queue for '%s'...\n", time(NULL), order->symbol);
+                LOG_ERROR("Unable to add order %lu to the index", order->oid);
             }
-
-            // Add to Redis
             if (!init)
             {
-                uint64_t add_redis_status = add_order_to_redis(red_con, order);
-                printf("%lu: Order is added to Redis with status '%lu'\n", time(NULL), add_redis_status);
+                persist_order(me, PERSIST_CANCEL, resting_order);
+                persist_order(me, PERSIST_ORDER, order);
             }
+            pool_free(&me->orders, resting_order);
+            return;
+        }
+
+        // Otherwise the resting order is cancelled and the replacement is matched as the new order
+        if (!init)
+        {
+            LOG_INFO("Order %lu is replaced with order %lu", resting_order->oid, order->oid);
         }
+        cancel_order(me, resting_order, init);
     }
 
-    // For sell operation
+    // Validate the symbol is resolved
+    if (order->symbol_id >= MAX_SYMBOLS)
+    {
+        LOG_ERROR("Order %lu has unknown symbol '%s'", order->oid, order->symbol);
+        pool_free(&me->orders, order);
+        return;
+    }
+    order_book_t *book = &me->books[order->symbol_id];
+
+    // Pick the queues for the order's side
+    book_side_t *own_side = NULL;
+    book_side_t *opposite_side = NULL;
+    if (order->operation == 1)
+    {
+        own_side = &book->buy;
+        opposite_side = &book->sell;
+    }
     else if (order->operation == 0)
     {
-        printf("%lu: Sell order from '%s' for '%s' with price '%f' and quantity '%lu'\n",
-               time(NULL),
-               order->cid,
-               order->symbol,
-               order->price,
-               order->quantity);
-
-        // Check if there are any buy orders
-        if (tt_ptr->buy_head != NULL)
+        own_side = &book->sell;
+        opposite_side = &book->buy;
+    }
+
+    // For buy and sell operations
+    if (own_side != NULL)
+    {
+        LOG_DEBUG("%s order from '%s' for '%s' with price '%lu.%02lu' and quantity '%lu'",
+                  order->operation == 1 ? "Buy" : "Sell",
+                  order->cid,
+                  order->symbol,
+                  order->price / PRICE_SCALE,
+                  order->price % PRICE_SCALE,
+                  order->quantity);
+
+        // Sweep the price levels crossed by the order, starting from the best one, in time priority
+        uint64_t t_match = 0;
+        uint64_t fills = 0;
+        while (order->quantity > 0)
         {
-            printf("%lu: Looking for existing orders in the buy queue for '%s' ...\n", time(NULL), order->symbol);
+            price_level_t *level = get_best_level(opposite_side);
+            if (level == NULL || !is_price_crossing(opposite_side, level, order->price))
+            {
+                break;
+            }
 
-            // Loop through the buy orders
-            order_t *buy_order = tt_ptr->buy_head;
-            while (buy_order != NULL && !is_matched)
+            // Fill against the oldest order on the level
+            order_t *resting_order = level->head;
+            uint64_t quantity = order->quantity < resting_order->quantity ? order->quantity : resting_order->quantity;
+
+            // Create execution, which is traded at the price of the resting order
+            execution_t *execution = pool_alloc(&me->executions);
+            if (execution == NULL)
             {
-                printf("%lu: There are orders in the buy queue for '%s'! Checking them...\n", time(NULL), order->symbol);
-                printf("%lu: Buy order from '%s' for '%s' with price '%.2f' and quantity '%lu'\n",
-                       time(NULL),
-                       buy_order->cid,
-                       buy_order->symbol,
-                       buy_order->price,
-                       buy_order->quantity);
-
-                // Check if the sell price is lower or equal to the buy price
-                if (order->price <= buy_order->price)
-                {
-                    printf("%lu: Sell price '%.2f' is lower than or equal to the buy price '%.2f', checking quantity...\n",
-                           time(NULL),
-                           order->price,
-                           buy_order->price);
-
-                    // Check if the buy quantity is equal to the sell quantity
-                    if (order->quantity == buy_order->quantity)
-                    {
-
-                        printf("%lu: Sell quantity %lu equals to buy quantity %lu. Order is matched!\n",
-                               time(NULL),
-                               order->quantity,
-                               buy_order->quantity);
-
-                        // Remove from the buy list
-                        // Relinking the right part of the node
-                        if (buy_order->next != NULL)
-                        {
-                            buy_order->next->previous = buy_order->previous;
-                        }
-                        else
-                        {
-                            tt_ptr->buy_tail = buy_order->previous;
-                        }
-
-                        // Relinking the left part of the node
-                        if (buy_order->previous != NULL)
-                        {
-                            buy_order->previous->next = buy_order->next;
-                        }
-                        else
-                        {
-                            tt_ptr->buy_head = buy_order->next;
-                        }
-
-                        // Adjust the price for more prefferable one (i.e, buy cheaper)
-                        if (order->price < buy_order->price)
-                        {
-                            buy_order->price = order->price;
-                        }
-
-                        // Add to the executed orders list
-                        order_t *temp = executed_orders;
-                        executed_orders = buy_order;
-                        executed_orders->next = temp;
-                        executed_orders->previous = NULL;
-
-                        // Move the sell order to the list of the executed orders
-                        temp = executed_orders;
-                        executed_orders = order;
-                        executed_orders->next = temp;
-                        executed_orders->previous = NULL;
-
-                        // Communicate that order is mathced
-                        is_matched = true;
-                    }
-                    // If the quality is not equal, move to the next sell order
-                    else
-                    {
-                        printf("%lu: Sell quantity %lu doesn't equal buy quantity %lu, moving to the next sell order.\n",
-                               time(NULL),
-                               order->quantity,
-                               buy_order->quantity);
-
-                        buy_order = buy_order->next;
-                    }
-                }
-                // If the buy price is lower than the sell price, move to the next sell order
-                else
-                {
-                    printf("%lu: Sell price '%.2f' is higher than the buy price '%.2f', moving to the next sell order.\n",
-                           time(NULL),
-                           order->price,
-                           buy_order->price);
+                LOG_ERROR("Unable to allocate memory for execution");
+                break;
+            }
+            if (t_match == 0)
+            {
+                t_match = get_time_nanoseconds_since_midnight(get_time_nanoseconds_midnight());
+            }
+            memcpy(execution->symbol, order->symbol, sizeof(execution->symbol));
+            execution->t_server = t_match;
+            execution->match_id = (order->oid << MATCH_FILL_BITS) | (fills++ & ((1UL << MATCH_FILL_BITS) - 1));
+            execution->operation = order->operation;
+            execution->price = level->price;
+            execution->quantity = quantity;
+            execution->aggressor_oid = order->oid;
+            execution->aggressor_t_server = order->t_server;
+            memcpy(execution->aggressor_cid, order->cid, sizeof(execution->aggressor_cid));
+            execution->resting_oid = resting_order->oid;
+            execution->resting_t_server = resting_order->t_server;
+            memcpy(execution->resting_cid, resting_order->cid, sizeof(execution->resting_cid));
+
+            // Update quantities of both orders
+            order->quantity -= quantity;
+            execution->aggressor_leaves = order->quantity;
+            execution->resting_leaves = fill_order_in_book(opposite_side, resting_order, quantity);
+
+            // Executions are reported once, not again when the journal is replayed
+            if (!init)
+            {
+                LOG_INFO("Order %lu is matched with order %lu for '%s' of '%lu' at '%lu.%02lu'",
+                         order->oid,
+                         resting_order->oid,
+                         order->symbol,
+                         quantity,
+                         execution->price / PRICE_SCALE,
+                         execution->price % PRICE_SCALE);
+            }
 
-                    buy_order = buy_order->next;
-                }
+            // Resting order is fully filled and already removed from the book
+            if (execution->resting_leaves == 0)
+            {
+                remove_order_from_index(&me->index, resting_order->oid);
+                pool_free(&me->orders, resting_order);
             }
 
-            // If order is not matched, add it to the sell list
-            if (!is_matched)
+            // Add to the executed orders list
+            if (executions_tail == NULL)
             {
-                printf("%lu: There are no matching sell orders for by of '%s' of '%lu' at '%.2f'. Adding to the queue...\n",
-                       time(NULL),
-                       order->symbol,
-                       order->quantity,
-                       order->price);
-
-                // Add to the begining of the list if there are no orders
-                if (tt_ptr->sell_head == NULL)
-                {
-                    tt_ptr->sell_head = order;
-                    tt_ptr->sell_tail = order;
+                executions = execution;
+            }
+            else
+            {
+                executions_tail->next = execution;
+            }
+            executions_tail = execution;
+        }
 
-                    printf("%lu: Order is added to the beginning of the sell queue for '%s'...\n", time(NULL), order->symbol);
-                }
-                // Add to the end, if there are orders
-                else
-                {
-                    tt_ptr->sell_tail->next = order;
-                    tt_ptr->sell_tail = order;
+        // Executions are persisted before the remainder of the order, so the book events follow the sequence of the match
+        if (!init && me->persistence != NULL)
+        {
+            for (execution_t *head = executions; head != NULL; head = head->next)
+            {
+                persistence_event_t event;
+                event.type = PERSIST_EXECUTION;
+                event.execution = *head;
+                persist_event(me->persistence, &event);
+            }
+        }
+
+        // If order is not fully matched, add the remaining quantity to its queue
+        if (order->quantity > 0)
+        {
+            LOG_DEBUG("There are no more matching orders for '%s' of '%lu' at '%lu.%02lu'. Adding to the queue...",
+                      order->symbol,
+                      order->quantity,
+                      order->price / PRICE_SCALE,
+                      order->price % PRICE_SCALE);
 
-                    printf("%lu: Order is added to the end of the sell queue for '%s'...\n", time(NULL), order->symbol);
+            if (add_order_to_book(own_side, order) != 0)
+            {
+                LOG_ERROR("Unable to add order %lu to the queue", order->oid);
+                pool_free(&me->orders, order);
+                order = NULL;
+            }
+            else
+            {
+                // Index the resting order for cancel and replace
+                if (add_order_to_index(&me->index, order) != 0)
+                {
+                    LOG_ERROR("Unable to add order %lu to the index", order->oid);
                 }
 
                 // Add to Redis
                 if (!init)
                 {
-                    int add_redis_status = add_order_to_redis(red_con, order);
-                    printf("%lu: Order is added to Redis with status '%i'\n", time(NULL), add_redis_status);
+                    persist_order(me, PERSIST_ORDER, order);
                 }
             }
         }
-        // If there are no orders to match, add order to the trie
+        // Keep details of the fully filled order for the execution notification
         else
         {
-            printf("%lu: There are no orders in the buy queue for '%s', adding to the buy queue...\n", time(NULL), order->symbol);
-
-            // Add to the begining of the list if there are no orders
-            if (tt_ptr->sell_head == NULL)
-            {
-                tt_ptr->sell_head = order;
-                tt_ptr->sell_tail = order;
-
-                printf("%lu: Order is added to the beginning of the sell queue for '%s'...\n", time(NULL), order->symbol);
-            }
-            // Add to the end, if there are orders
-            else
-            {
-                tt_ptr->sell_tail->next = order;
-                tt_ptr->sell_tail = order;
-
-                printf("%lu: Order is added to the end of the sell queue for '%s'...\n", time(NULL), order->symbol);
-            }
-
-            // Add to Redis
             if (!init)
             {
-                int add_redis_status = add_order_to_redis(red_con, order);
-                printf("%lu: Order is added to Redis with status '%i'\n", time(NULL), add_redis_status);
+                persist_order(me, PERSIST_ORDER_DETAILS, order);
             }
+            pool_free(&me->orders, order);
+            order = NULL;
         }
     }
 
-    // For cancell operation
-    else if (order->operation == 2)
+    // Unknown operation
+    else
     {
-        // Add some code
+        LOG_ERROR("Order %lu has unknown operation '%lu'", order->oid, order->operation);
+        pool_free(&me->orders, order);
     }
 
-    // If there are matched orders, push them to executed_orders in Redis
-    if (is_matched)
+    // Trades are reported on the Last Sale channel straight from the match, the batch is sent by the order loop
+    if (!init && me->last_sale != NULL)
     {
-        if (add_order_to_redis_details(red_con, order) > 0)
-        {
-            perror("Error: Cannot add Redis order details: ");
-        }
-        if (move_orders_to_exec_queue_redis(red_con, executed_orders) > 0)
+        for (execution_t *head = executions; head != NULL; head = head->next)
         {
-            perror("Error: Cannot move redis order to executed queue: ");
+            if (publish_trade_report(me->last_sale, head) != 0)
+            {
+                LOG_ERROR("Unable to publish trade %lu of order %lu", head->match_id, head->aggressor_oid);
+            }
         }
     }
 
     // Print list of executed orders for debug purposes
-    // print_executed_orders(executed_orders);
+    // print_executed_orders(executions);
 
     // Cleanup
-    free_order_list(executed_orders);
-}
-
-void print_trie(trading_trie_t *tt)
-{
-    /* Helper function to print the trie for debug purpose*/
-
-    // Prints the nodes of the trie
-    if (!tt)
-        return;
-
-    trading_trie_t *temp = tt;
-    printf("%c -> ", temp->symbol);
-    for (uint64_t i = 0; i < N; i++)
-    {
-        print_trie(temp->next[i]);
-    }
+    free_execution_list(&me->executions, executions);
 }
 
-void print_executed_orders(order_t *executed_orders)
+void print_executed_orders(execution_t *executions)
 {
     /* Helper function to print the executed orders for debug purpose*/
 
     printf("%lu: EXECUTED ORDERS:\n", time(NULL));
 
-    order_t *head = executed_orders;
+    execution_t *head = executions;
     while (head != NULL)
     {
-        printf("- cid: %s\n  oid: %lu\n  t_client: %lu\n  t_server: %lu\n  symbol: %s\n  op: %lu\n  price: %f\n  qty: %lu\n",
-               head->cid,
-               head->oid,
-               head->t_client,
-               head->t_server,
+        printf("- symbol: %s\n  t_server: %lu\n  op: %lu\n  price: %lu\n  qty: %lu\n  aggressor: %lu (leaves %lu)\n  resting: %lu (leaves %lu)\n",
                head->symbol,
+               head->t_server,
                head->operation,
                head->price,
-               head->quantity);
+               head->quantity,
+               head->aggressor_oid,
+               head->aggressor_leaves,
+               head->resting_oid,
+               head->resting_leaves);
         head = head->next;
     }
 }
 
-void free_trie(trading_trie_t *tt)
+void free_matching_engine(matching_engine_t *me)
 {
-    /* Helper function to clean up the memory used in trie*/
-    for (uint64_t i = 0; i < N; i++)
+    /* Helper function to clean up the memory used in matching engine*/
+    for (uint64_t i = 0; i < me->symbols.symbols; i++)
     {
-        if (tt->next[i] != NULL)
-        {
-            free_trie(tt->next[i]);
-            // free(tt->next[i]);
-        }
+        free_book_side(&me->books[i].buy);
+        free_book_side(&me->books[i].sell);
     }
 
-    // Cleanup queues
-    if (tt->buy_head != NULL)
-    {
-        free_order_list(tt->buy_head);
-    }
-
-    if (tt->sell_head != NULL)
-    {
-        free_order_list(tt->sell_head);
-    }
+    // Resting orders and price levels are released together with pools
+    free_pool(&me->orders);
+    free_pool(&me->executions);
+    free_pool(&me->levels);
+    free_order_index(&me->index);
 
     // Cleanup
-    free(tt);
+    free(me);
 }
 
 void free_order_list(order_t *executed_orders)
@@ -523,4 +435,18 @@ void free_order_list(order_t *executed_orders)
         head = head->next;
         free(temp);
     }
+}
+
+void free_execution_list(pool_t *pool, execution_t *executions)
+{
+    /* Helper function to return executions to the pool*/
+
+    // Go through the list to release memory
+    execution_t *head = executions;
+    while (head != NULL)
+    {
+        execution_t *temp = head;
+        head = head->next;
+        pool_free(pool, temp);
+    }
 }
\ No newline at end of file
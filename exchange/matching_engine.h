@@ -1,16 +1,15 @@
-/* This file contains header for the bespoke logic of building trading trie */
+/* This file contains header for the bespoke logic of building and matching order books */
 
 // Preprocessor directives
 #include <stdbool.h>
-#include <hiredis/hiredis.h>
 
 // Local headers
 #include "types.h"
 
 // Declare function prototypes
-trading_trie_t *add_node_to_trie(char symbol);
-void match_trade(trading_trie_t *tt, order_t *order, redisContext *red_con, bool init);
-void free_trie(trading_trie_t *tt);
+matching_engine_t *create_matching_engine(void);
+void match_trade(matching_engine_t *me, order_t *order, bool init);
+void free_matching_engine(matching_engine_t *me);
 void free_order_list(order_t *executed_orders);
-void print_trie(trading_trie_t *tt);
-void print_executed_orders(order_t *executed_orders);
\ No newline at end of file
+void free_execution_list(pool_t *pool, execution_t *executions);
+void print_executed_orders(execution_t *executions);
\ No newline at end of file
@@ -0,0 +1,224 @@
+/* This file contains the copy of the order books kept by market_data: the books are built from the same events,
+   which are sent as deltas, so that their snapshot is consistent with the sequence number of the feed.
+   The books reuse the price-level book, the order index and the pools of the matching engine. Symbols, which books
+   changed, are remembered, so that only their quotes are taken for the QBBO channel. */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <hiredis/hiredis.h>
+
+// Local headers
+#include "md_book.h"
+#include "order_book.h"
+#include "order_index.h"
+#include "symbol_directory.h"
+#include "serializers.h"
+#include "pool.h"
+#include "log.h"
+
+// Define aux functions
+static book_side_t *get_md_book_side(md_book_t *book, order_t *order)
+{
+    /* Helper function to get the side of the book, where the resting order is queued */
+    order_book_t *order_book = &book->books[order->symbol_id];
+    return order->operation == 1 ? &order_book->buy : &order_book->sell;
+}
+
+static void mark_md_quote(md_book_t *book, uint64_t symbol_id)
+{
+    /* Helper function to remember, that the book of the symbol changed since its quote was sent */
+    if (!book->is_changed[symbol_id])
+    {
+        book->is_changed[symbol_id] = true;
+        book->changed_symbols[book->changed++] = symbol_id;
+    }
+}
+
+static void requeue_md_order(order_t *order)
+{
+    /* Helper function to move the order, which was added to the end of its price level, in front of the younger
+       orders. Replacement, which keeps the time priority, is published as the add with the time of the replaced
+       order, so it is queued where the replaced order was. */
+    price_level_t *level = order->level;
+    order_t *position = order->previous;
+    while (position != NULL && position->t_server > order->t_server)
+    {
+        position = position->previous;
+    }
+    if (position == order->previous)
+    {
+        return;
+    }
+
+    // Unlink the order from the end of the queue
+    level->tail = order->previous;
+    level->tail->next = NULL;
+
+    // Link it after the position, or at the head
+    order->previous = position;
+    order->next = position == NULL ? level->head : position->next;
+    order->next->previous = order;
+    if (position == NULL)
+    {
+        level->head = order;
+    }
+    else
+    {
+        position->next = order;
+    }
+}
+
+static uint64_t add_order_to_md_book(md_book_t *book, char *symbol, uint64_t oid, uint64_t operation, price_t price,
+                                     uint64_t quantity, uint64_t t_server)
+{
+    /* Helper function to add the resting order to its price level in the time priority. The order, which is already
+       in the book, is skipped, so that the event, which is already reflected in the loaded books, isn't applied twice. */
+    if (quantity == 0 || find_order_in_index(&book->index, oid) != NULL)
+    {
+        return 0;
+    }
+
+    uint64_t symbol_id = intern_symbol(&book->symbols, symbol);
+    if (symbol_id == MAX_SYMBOLS)
+    {
+        return 1;
+    }
+
+    order_t *order = pool_alloc(&book->orders);
+    if (order == NULL)
+    {
+        return 2;
+    }
+    memset(order, 0, sizeof(order_t));
+    strncpy(order->symbol, book->symbols.names[symbol_id], SYMBOL_LEN);
+    order->symbol_id = symbol_id;
+    order->oid = oid;
+    order->operation = operation;
+    order->price = price;
+    order->quantity = quantity;
+    order->t_server = t_server;
+
+    if (add_order_to_book(get_md_book_side(book, order), order) != 0 || add_order_to_index(&book->index, order) != 0)
+    {
+        return 3;
+    }
+    requeue_md_order(order);
+    mark_md_quote(book, symbol_id);
+
+    // Success
+    return 0;
+}
+
+uint64_t init_md_book(md_book_t *book)
+{
+    /* Helper function to initialize empty books, the structure is expected to be zeroed */
+    if (init_pool(&book->orders, sizeof(order_t), POOL_ORDERS_SLAB) != 0 ||
+        init_pool(&book->levels, sizeof(price_level_t), POOL_LEVELS_SLAB) != 0 ||
+        init_order_index(&book->index, ORDER_INDEX_INITIAL_CAPACITY) != 0)
+    {
+        return 1;
+    }
+
+    for (uint64_t i = 0; i < MAX_SYMBOLS; i++)
+    {
+        init_book_side(&book->books[i].sell, 0, &book->levels);
+        init_book_side(&book->books[i].buy, 1, &book->levels);
+    }
+
+    // Success
+    return 0;
+}
+
+uint64_t load_md_book(md_book_t *book, redisContext *red_con)
+{
+    /* Helper function to load the resting orders from Redis in their priority. Returns the number of loaded orders. */
+    uint64_t loaded = 0;
+    order_t *order = deserialize_order_redis(red_con, REDIS_EXCHANGE_A_ORDERS);
+    while (order != NULL)
+    {
+        order_t *next = order->next;
+        if (add_order_to_md_book(book, order->symbol, order->oid, order->operation, order->price, order->quantity,
+                                 order->t_server) == 0)
+        {
+            loaded++;
+        }
+        free(order);
+        order = next;
+    }
+
+    return loaded;
+}
+
+uint64_t apply_book_event(md_book_t *book, book_event_t *event)
+{
+    /* Helper function to apply the change of the resting order. Fill sets the remaining quantity instead of
+       subtracting the filled one, so that all events can be applied again without changing the books. */
+    if (event->type == MD_EVENT_ADD)
+    {
+        return add_order_to_md_book(book, event->symbol, event->oid, event->operation, event->price, event->quantity,
+                                    event->t_server);
+    }
+
+    else if (event->type != MD_EVENT_EXECUTE && event->type != MD_EVENT_CANCEL)
+    {
+        return 4;
+    }
+
+    // Order may have been removed already
+    order_t *order = find_order_in_index(&book->index, event->oid);
+    if (order == NULL)
+    {
+        return 0;
+    }
+
+    book_side_t *side = get_md_book_side(book, order);
+    mark_md_quote(book, order->symbol_id);
+    if (event->type == MD_EVENT_EXECUTE && event->leaves > 0)
+    {
+        if (event->leaves < order->quantity)
+        {
+            fill_order_in_book(side, order, order->quantity - event->leaves);
+        }
+        return 0;
+    }
+
+    // Fully filled or cancelled order leaves the book
+    remove_order_from_book(side, order);
+    remove_order_from_index(&book->index, order->oid);
+    pool_free(&book->orders, order);
+
+    // Success
+    return 0;
+}
+
+bool update_md_quote(md_book_t *book, uint64_t symbol_id)
+{
+    /* Helper function to take the best bid and offer of the symbol with their sizes, the empty side is zero.
+       Returns `true` if the quote differs from the last one taken. */
+    md_quote_t quote;
+    memset(&quote, 0, sizeof(quote));
+    price_level_t *bid = get_best_level(&book->books[symbol_id].buy);
+    price_level_t *ask = get_best_level(&book->books[symbol_id].sell);
+    if (bid != NULL)
+    {
+        quote.bid_price = bid->price;
+        quote.bid_size = bid->quantity;
+    }
+    if (ask != NULL)
+    {
+        quote.ask_price = ask->price;
+        quote.ask_size = ask->quantity;
+    }
+
+    if (memcmp(&quote, &book->quotes[symbol_id], sizeof(quote)) == 0)
+    {
+        return false;
+    }
+    book->quotes[symbol_id] = quote;
+
+    return true;
+}
\ No newline at end of file
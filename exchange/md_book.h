@@ -0,0 +1,15 @@
+/* This file contains header for the copy of the order books kept by market_data to send their snapshots */
+
+// Preprocessor directives
+#include <stdint.h>
+#include <stdbool.h>
+#include <hiredis/hiredis.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t init_md_book(md_book_t *book);
+uint64_t load_md_book(md_book_t *book, redisContext *red_con);
+uint64_t apply_book_event(md_book_t *book, book_event_t *event);
+bool update_md_quote(md_book_t *book, uint64_t symbol_id);
\ No newline at end of file
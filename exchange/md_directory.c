@@ -0,0 +1,186 @@
+/* This file contains the channel directory of market data: symbols are sharded across the channels by the hash
+   of the symbol, so the channel doesn't depend on the order in which symbols appear and is the same after restart.
+   The directory thread tells the client the channels of its symbols and the addresses of all channels over TCP. */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <byteswap.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+
+// Local headers
+#include "md_directory.h"
+#include "symbol_directory.h"
+#include "log.h"
+
+// Define aux functions
+static uint64_t recv_request(int64_t sd, char *buffer, uint64_t length)
+{
+    /* Helper function to receive exactly `length` bytes of the request */
+    uint64_t received = 0;
+    while (received < length)
+    {
+        int64_t n = recv(sd, buffer + received, length - received, 0);
+        if (n <= 0)
+        {
+            return 1;
+        }
+        received += n;
+    }
+
+    return 0;
+}
+
+static void serve_request(md_directory_t *directory, int64_t sd)
+{
+    /* Helper function to read the symbols of the client and to send the channels back */
+    md_directory_request_t request;
+    if (recv_request(sd, (char *)&request, sizeof(request)) != 0)
+    {
+        LOG_ERROR("Unable to receive directory request");
+        return;
+    }
+    uint64_t count = bswap_16(request.count);
+    if (count > MD_MAX_DIRECTORY_SYMBOLS)
+    {
+        LOG_ERROR("Directory request for %lu symbols is too big", count);
+        return;
+    }
+
+    static char symbols[MD_MAX_DIRECTORY_SYMBOLS][SYMBOL_LEN];
+    if (count > 0 && recv_request(sd, (char *)symbols, count * SYMBOL_LEN) != 0)
+    {
+        LOG_ERROR("Unable to receive directory request");
+        return;
+    }
+
+    // Response has the layout of the request: header, channels and symbols, all of them are fixed-length
+    static char response[sizeof(md_directory_header_t) + MD_MAX_CHANNELS * sizeof(md_directory_channel_t) +
+                         MD_MAX_DIRECTORY_SYMBOLS * sizeof(md_directory_symbol_t)];
+    md_directory_header_t *header = (md_directory_header_t *)response;
+    memcpy(header->session, directory->session, MD_SESSION_LEN);
+    header->channels = bswap_16(directory->channels);
+    header->count = bswap_16(count);
+    uint64_t length = sizeof(md_directory_header_t);
+
+    for (uint64_t i = 0; i < directory->channels; i++)
+    {
+        md_directory_channel_t *channel = (md_directory_channel_t *)(response + length);
+        channel->channel = bswap_16(i);
+        channel->group = directory->groups[i].sin_addr.s_addr;
+        channel->port = directory->groups[i].sin_port;
+        channel->snapshot_group = directory->snapshot_groups[i].sin_addr.s_addr;
+        channel->snapshot_port = directory->snapshot_groups[i].sin_port;
+        channel->rewind_port = bswap_16(directory->rewind_ports[i]);
+        length += sizeof(md_directory_channel_t);
+    }
+
+    // Symbols are interned in upper case, so they are hashed the same way
+    for (uint64_t i = 0; i < count; i++)
+    {
+        char stock[SYMBOL_LEN + 1];
+        memset(stock, '\0', sizeof(stock));
+        for (uint64_t j = 0; j < SYMBOL_LEN && symbols[i][j] != '\0'; j++)
+        {
+            stock[j] = toupper(symbols[i][j]);
+        }
+
+        md_directory_symbol_t *symbol = (md_directory_symbol_t *)(response + length);
+        memcpy(symbol->stock, stock, SYMBOL_LEN);
+        symbol->channel = bswap_16(get_symbol_channel(stock, directory->channels));
+        length += sizeof(md_directory_symbol_t);
+    }
+
+    if (send(sd, response, length, MSG_NOSIGNAL) < 0)
+    {
+        LOG_ERROR("Unable to send directory response");
+        return;
+    }
+    LOG_INFO("Sent directory of %lu channels and %lu symbols", directory->channels, count);
+}
+
+static void *directory_worker(void *arg)
+{
+    /* Directory thread, which serves requests one by one, each on its own connection */
+    md_directory_t *directory = arg;
+    while (1)
+    {
+        struct sockaddr_in client_addr;
+        socklen_t client_addr_len = sizeof(client_addr);
+        int64_t sd = accept(directory->sd, (struct sockaddr *)&client_addr, &client_addr_len);
+        if (sd < 0)
+        {
+            LOG_ERROR("Unable to accept directory request");
+            continue;
+        }
+
+        // Slow client can't block others for longer than the timeout
+        struct timeval timeout;
+        timeout.tv_sec = MD_REWIND_TIMEOUT;
+        timeout.tv_usec = 0;
+        setsockopt(sd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(sd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        serve_request(directory, sd);
+        close(sd);
+    }
+
+    return NULL;
+}
+
+uint64_t get_symbol_channel(char *symbol, uint64_t channels)
+{
+    /* Helper function to get the channel, which the messages of the symbol are sent on */
+    return hash_symbol(symbol) % channels;
+}
+
+uint64_t start_directory(md_directory_t *directory, server_t *addr_directory)
+{
+    /* Helper function to open the TCP server for directory requests and to start the directory thread.
+       Session and addresses of the channels are set by the caller and don't change afterwards. */
+    directory->sd = socket(AF_INET, SOCK_STREAM, addr_directory->protocol);
+    if (directory->sd < 0)
+    {
+        perror("Error: Cannot create socket: ");
+        return 1;
+    }
+
+    int optval = 1;
+    if (setsockopt(directory->sd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0)
+    {
+        perror("Error: Cannot set socket option: ");
+        return 2;
+    }
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(addr_directory->port);
+    if (inet_pton(AF_INET, addr_directory->ip, &server_addr.sin_addr) <= 0)
+    {
+        perror("Error: Uncompatible IP Address: ");
+        return 3;
+    }
+
+    if (bind(directory->sd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0 || listen(directory->sd, SOMAXCONN) < 0)
+    {
+        perror("Error: Cannot listen for directory requests: ");
+        return 4;
+    }
+
+    if (pthread_create(&directory->thread, NULL, directory_worker, directory) != 0)
+    {
+        perror("Error: Cannot start directory thread: ");
+        return 5;
+    }
+
+    // Success
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+/* This file contains header for the channel directory of market data, which tells clients where their symbols are sent */
+
+// Preprocessor directives
+#include <stdint.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t get_symbol_channel(char *symbol, uint64_t channels);
+uint64_t start_directory(md_directory_t *directory, server_t *addr_directory);
\ No newline at end of file
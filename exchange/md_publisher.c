@@ -0,0 +1,196 @@
+/* This file contains the publisher of market data: ITCH-style binary messages are packed into MoldUDP64-style
+   datagrams, which fit into the MTU, and the batch of datagrams is sent with one `sendmmsg` call. It is shared by
+   market_data, which sends the book deltas, and by the matching engine, which sends the trades as they are matched. */
+
+// Preprocessor directives
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+// Local headers
+#include "md_publisher.h"
+#include "retransmit.h"
+
+// Define aux functions
+uint64_t get_time_microseconds(void)
+{
+    /* Helper function to get monotonic time in microseconds for the latency bound of the partial datagram */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint64_t open_md_publisher(md_publisher_t *publisher, server_t *addr_group, server_t *addr_source, char *session,
+                           uint64_t max_delay)
+{
+    /* Helper function to open the socket of the publisher, which sends to the multicast group from the interface
+       of the source address. The publisher starts the session from the first sequence number. */
+    publisher->sd = socket(AF_INET, SOCK_DGRAM, addr_group->protocol);
+    if (publisher->sd < 0)
+    {
+        perror("Error: Cannot create socket: ");
+        return 1;
+    }
+
+    struct in_addr addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.s_addr = inet_addr(addr_source->ip);
+    if (setsockopt(publisher->sd, IPPROTO_IP, IP_MULTICAST_IF, &addr, sizeof(addr)) < 0)
+    {
+        perror("Error: Cannot set socket option: ");
+        return 2;
+    }
+
+    memset(&publisher->addr, 0, sizeof(publisher->addr));
+    publisher->addr.sin_family = AF_INET;
+    publisher->addr.sin_port = htons(addr_group->port);
+    if (inet_pton(AF_INET, addr_group->ip, &publisher->addr.sin_addr) <= 0)
+    {
+        perror("Error: Uncompatible IP Address: ");
+        return 3;
+    }
+
+    memcpy(publisher->session, session, MD_SESSION_LEN);
+    publisher->sequence = 1;
+    publisher->max_delay = max_delay;
+    publisher->packets = 0;
+
+    // Success
+    return 0;
+}
+
+uint64_t flush_md_packets(md_publisher_t *publisher)
+{
+    /* Helper function to send all datagrams of the batch, including the partial one, with as few syscalls as possible */
+    struct mmsghdr msgs[MD_MAX_PACKETS];
+    struct iovec iovecs[MD_MAX_PACKETS];
+    memset(msgs, 0, sizeof(msgs));
+
+    // Number of messages is known only when the datagram is closed
+    for (uint64_t i = 0; i < publisher->packets; i++)
+    {
+        md_packet_header_t *header = (md_packet_header_t *)publisher->buffers[i];
+        header->count = bswap_16(publisher->counts[i]);
+
+        // Datagram may be lost, so its messages are kept for retransmission before it is sent
+        if (publisher->retransmit != NULL)
+        {
+            store_md_packet(publisher->retransmit, publisher->buffers[i], publisher->lengths[i]);
+        }
+
+        iovecs[i].iov_base = publisher->buffers[i];
+        iovecs[i].iov_len = publisher->lengths[i];
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &publisher->addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(publisher->addr);
+    }
+
+    // Kernel may send only part of the batch, the rest is sent with the next call
+    uint64_t sent = 0;
+    while (sent < publisher->packets)
+    {
+        int n = sendmmsg(publisher->sd, msgs + sent, publisher->packets - sent, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // Batch is dropped, so each sequence number is stored once, the gap is recovered by retransmission
+            printf("%lu: Unable to send multicast message, %lu datagrams are dropped: %s\n",
+                   time(NULL),
+                   publisher->packets - sent,
+                   strerror(errno));
+            publisher->packets = 0;
+            return 1;
+        }
+        sent += n;
+    }
+
+    // Start the new batch
+    publisher->packets = 0;
+
+    return 0;
+}
+
+char *get_md_message(md_publisher_t *publisher, uint64_t length)
+{
+    /* Helper function to reserve space for the message in the open datagram. The datagram is closed when the message
+       doesn't fit into it, and the batch is sent when all datagrams are used. The batch, which can't be sent, is
+       dropped and the message still gets its sequence number, so subscribers see the gap and request it again. */
+    uint64_t i = publisher->packets - 1;
+    if (publisher->packets == 0 || publisher->lengths[i] + sizeof(uint16_t) + length > MD_MAX_PAYLOAD)
+    {
+        if (publisher->packets == MD_MAX_PACKETS)
+        {
+            flush_md_packets(publisher);
+        }
+
+        // Open the new datagram, its header carries the sequence number of the first message
+        i = publisher->packets++;
+        md_packet_header_t *header = (md_packet_header_t *)publisher->buffers[i];
+        memcpy(header->session, publisher->session, MD_SESSION_LEN);
+        header->sequence = bswap_64(publisher->sequence);
+        publisher->lengths[i] = sizeof(md_packet_header_t);
+        publisher->counts[i] = 0;
+        if (i == 0)
+        {
+            publisher->t_open = get_time_microseconds();
+        }
+    }
+
+    // Message is prefixed with its length
+    char *message = publisher->buffers[i] + publisher->lengths[i];
+    uint16_t length_be = bswap_16(length);
+    memcpy(message, &length_be, sizeof(length_be));
+    publisher->lengths[i] += sizeof(uint16_t) + length;
+    publisher->counts[i]++;
+    publisher->sequence++;
+
+    return message + sizeof(uint16_t);
+}
+
+uint64_t publish_system_event(md_publisher_t *publisher, char event_code, uint64_t timestamp)
+{
+    /* Helper function to add the system event message, e.g. start of messages */
+    md_system_event_message_t *message = (md_system_event_message_t *)get_md_message(publisher, sizeof(md_system_event_message_t));
+    if (message == NULL)
+    {
+        return 1;
+    }
+    message->type = MD_EVENT_SYSTEM;
+    message->timestamp = bswap_64(timestamp);
+    message->event_code = event_code;
+
+    return 0;
+}
+
+uint64_t publish_trade_report(md_publisher_t *publisher, execution_t *execution)
+{
+    /* Helper function to add the trade message of the fill, the side is the side of the aggressor order */
+    md_trade_message_t *message = (md_trade_message_t *)get_md_message(publisher, sizeof(md_trade_message_t));
+    if (message == NULL)
+    {
+        return 1;
+    }
+    message->type = MD_EVENT_TRADE;
+    message->timestamp = bswap_64(execution->t_server);
+    message->side = execution->operation == 1 ? MD_SIDE_BUY : MD_SIDE_SELL;
+    message->shares = bswap_64(execution->quantity);
+    memcpy(message->stock, execution->symbol, SYMBOL_LEN);
+    message->price = bswap_64(execution->price);
+    message->match_number = bswap_64(execution->match_id);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+/* This file contains header for the publisher of market data, which packs messages into batches of datagrams */
+
+// Preprocessor directives
+#include <stdint.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t get_time_microseconds(void);
+uint64_t open_md_publisher(md_publisher_t *publisher, server_t *addr_group, server_t *addr_source, char *session,
+                           uint64_t max_delay);
+uint64_t flush_md_packets(md_publisher_t *publisher);
+char *get_md_message(md_publisher_t *publisher, uint64_t length);
+uint64_t publish_system_event(md_publisher_t *publisher, char event_code, uint64_t timestamp);
+uint64_t publish_trade_report(md_publisher_t *publisher, execution_t *execution);
\ No newline at end of file
@@ -0,0 +1,763 @@
+/* This file contains the execution notifier of exec. The reader thread blocks on the Redis stream of executions and
+   passes them through the ring to the event loop, which keeps one persistent non-blocking connection per customer.
+   Many notifications are in flight on each connection, acknowledgements are matched by order id, so one slow or
+   unreachable customer doesn't delay notifications of the others. */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <byteswap.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <arpa/inet.h>
+#include <hiredis/hiredis.h>
+
+// Local headers
+#include "notifier.h"
+#include "spsc_ring.h"
+#include "serializers.h"
+#include "customer_directory.h"
+#include "helper.h"
+#include "log.h"
+
+// Define aux functions
+static uint64_t get_time_milliseconds(void)
+{
+    /* Helper function to get monotonic time in milliseconds for the reconnect timers */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void *exec_reader_worker(void *arg)
+{
+    /* Reader thread, which blocks on the stream of executions and passes them to the event loop.
+       Executions delivered before the restart, but not acknowledged, are read first. */
+    notifier_t *notifier = arg;
+    char last_id[REDIS_STREAM_ID_LEN] = "0";
+    bool is_pending = true;
+
+    while (1)
+    {
+        redisReply *red_rep = redisCommand(notifier->red_con_reader, "XREADGROUP GROUP %s %s COUNT %d BLOCK 0 STREAMS %s %s",
+                                           REDIS_EXCHANGE_EXEC_GROUP,
+                                           REDIS_EXCHANGE_EXEC_CONSUMER,
+                                           REDIS_EXEC_READ_COUNT,
+                                           REDIS_EXCHANGE_EXEC_STREAM,
+                                           is_pending ? last_id : ">");
+        if (red_rep == NULL || red_rep->type == REDIS_REPLY_ERROR)
+        {
+            LOG_ERROR("Unable to read executions from Redis: %s", red_rep == NULL ? notifier->red_con_reader->errstr : red_rep->str);
+            exit(16);
+        }
+
+        // Reply contains one stream with the list of entries
+        redisReply *entries = NULL;
+        if (red_rep->type == REDIS_REPLY_ARRAY && red_rep->elements == 1)
+        {
+            entries = red_rep->element[0]->element[1];
+        }
+        if (entries == NULL || entries->elements == 0)
+        {
+            is_pending = false;
+            freeReplyObject(red_rep);
+            continue;
+        }
+
+        for (uint64_t i = 0; i < entries->elements; i++)
+        {
+            exec_notification_t notification;
+            uint64_t status = deserialize_execution_redis(entries->element[i], &notification);
+            strncpy(last_id, notification.stream_id, REDIS_STREAM_ID_LEN - 1);
+
+            // Corrupted executions can't be delivered, so they are acknowledged right away
+            if (status != 0)
+            {
+                LOG_ERROR("Execution %s is corrupted, skipped", notification.stream_id);
+                freeReplyObject(redisCommand(notifier->red_con_reader, "XACK %s %s %s",
+                                             REDIS_EXCHANGE_EXEC_STREAM,
+                                             REDIS_EXCHANGE_EXEC_GROUP,
+                                             notification.stream_id));
+                continue;
+            }
+
+            while (!spsc_ring_push(&notifier->ring, &notification))
+            {
+                sched_yield();
+            }
+        }
+        freeReplyObject(red_rep);
+
+        // Wake up the event loop once per batch
+        uint64_t signal = 1;
+        if (write(notifier->event_fd, &signal, sizeof(signal)) < 0)
+        {
+            LOG_ERROR("Unable to signal the event loop");
+        }
+    }
+
+    return NULL;
+}
+
+static void flush_acks(notifier_t *notifier)
+{
+    /* Helper function to read replies to the pipelined acknowledgements of the executions */
+    for (uint64_t i = 0; i < notifier->acks; i++)
+    {
+        redisReply *red_rep = NULL;
+        if (redisGetReply(notifier->red_con, (void **)&red_rep) != REDIS_OK)
+        {
+            LOG_ERROR("Unable to acknowledge executions in Redis: %s", notifier->red_con->errstr);
+            exit(1);
+        }
+        freeReplyObject(red_rep);
+    }
+    notifier->acks = 0;
+}
+
+static uint64_t find_in_flight_slot(customer_connection_t *connection, uint64_t oid)
+{
+    /* Helper function to find the slot of the order in the index of notifications in flight, or the free slot,
+       where it would be. The index is twice as big as the ring, so it is at most half full. */
+    uint64_t mask = connection->in_flight_capacity * 2 - 1;
+    uint64_t slot = oid & mask;
+    while (connection->in_flight_index[slot].oid != 0 && connection->in_flight_index[slot].oid != oid)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+static void remove_in_flight_entry(customer_connection_t *connection, uint64_t slot)
+{
+    /* Helper function to remove the order from the index. Following entries of the same cluster are shifted back,
+       so that lookups never need tombstones, the same way as in the index of resting orders. */
+    uint64_t mask = connection->in_flight_capacity * 2 - 1;
+    uint64_t next = slot;
+    while (1)
+    {
+        next = (next + 1) & mask;
+        if (connection->in_flight_index[next].oid == 0)
+        {
+            break;
+        }
+
+        uint64_t home = connection->in_flight_index[next].oid & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            connection->in_flight_index[slot] = connection->in_flight_index[next];
+            slot = next;
+        }
+    }
+    connection->in_flight_index[slot].oid = 0;
+}
+
+static void push_in_flight(customer_connection_t *connection, exec_notification_t *notification)
+{
+    /* Helper function to add the notification to the end of the ring, which must have space for it. Notifications
+       of the same order are chained from the oldest one, so that acknowledgement is matched with it in O(1). */
+    uint64_t position = connection->in_flight_tail++;
+    in_flight_notification_t *in_flight = &connection->in_flight[position & (connection->in_flight_capacity - 1)];
+    in_flight->notification = *notification;
+    in_flight->next = 0;
+    in_flight->is_acked = false;
+    connection->in_flight_count++;
+
+    in_flight_entry_t *entry = &connection->in_flight_index[find_in_flight_slot(connection, notification->oid)];
+    if (entry->oid == 0)
+    {
+        entry->oid = notification->oid;
+        entry->first = position;
+    }
+    else
+    {
+        connection->in_flight[entry->last & (connection->in_flight_capacity - 1)].next = position;
+    }
+    entry->last = position;
+}
+
+static uint64_t resize_in_flight(customer_connection_t *connection, uint64_t capacity)
+{
+    /* Helper function to move notifications in flight, which are not acknowledged yet, to the new ring
+       in the same sequence. Acknowledged ones are dropped, so it also compacts the ring. */
+    in_flight_notification_t *in_flight = calloc(capacity, sizeof(in_flight_notification_t));
+    in_flight_entry_t *in_flight_index = calloc(capacity * 2, sizeof(in_flight_entry_t));
+    if (in_flight == NULL || in_flight_index == NULL)
+    {
+        LOG_ERROR("Unable to allocate memory for notifications in flight");
+        free(in_flight);
+        free(in_flight_index);
+        return 1;
+    }
+
+    in_flight_notification_t *old_in_flight = connection->in_flight;
+    uint64_t old_mask = connection->in_flight_capacity - 1;
+    uint64_t old_head = connection->in_flight_head;
+    uint64_t old_tail = connection->in_flight_tail;
+    free(connection->in_flight_index);
+    connection->in_flight = in_flight;
+    connection->in_flight_index = in_flight_index;
+    connection->in_flight_capacity = capacity;
+    connection->in_flight_head = 0;
+    connection->in_flight_tail = 0;
+    connection->in_flight_count = 0;
+
+    for (uint64_t position = old_head; position != old_tail; position++)
+    {
+        if (!old_in_flight[position & old_mask].is_acked)
+        {
+            push_in_flight(connection, &old_in_flight[position & old_mask].notification);
+        }
+    }
+    free(old_in_flight);
+
+    // Success
+    return 0;
+}
+
+static uint64_t queue_notification_message(customer_connection_t *connection, exec_notification_t *notification)
+{
+    /* Helper function to add the notification message to the write queue of the connection */
+    uint64_t required = connection->write_length + sizeof(order_gateway_request_message_t);
+    if (required > connection->write_capacity)
+    {
+        uint64_t capacity = connection->write_capacity == 0 ? EXEC_BUFFER_LEN : connection->write_capacity * 2;
+        while (capacity < required)
+        {
+            capacity *= 2;
+        }
+        char *write_buffer = realloc(connection->write_buffer, capacity);
+        if (write_buffer == NULL)
+        {
+            LOG_ERROR("Unable to allocate memory for write queue");
+            return 1;
+        }
+        connection->write_buffer = write_buffer;
+        connection->write_capacity = capacity;
+    }
+
+    // Convert host byte order to network byte order
+    order_gateway_request_message_t ogm_output;
+    memset(&ogm_output, 0, sizeof(ogm_output));
+    ogm_output.order_id = bswap_64(notification->oid);
+    ogm_output.ts_placed = bswap_64(notification->t_server);
+    ogm_output.ts_executed = bswap_64(notification->t_exec);
+    ogm_output.status = notification->leaves == 0 ? 'E' : 'P';
+    memcpy(connection->write_buffer + connection->write_length, &ogm_output, sizeof(ogm_output));
+    connection->write_length += sizeof(ogm_output);
+
+    // Success
+    return 0;
+}
+
+static uint64_t flush_connection(customer_connection_t *connection)
+{
+    /* Helper function to send the write queue of the connection until the kernel buffer is full.
+       The rest is sent when epoll reports the socket writable again. */
+    while (connection->write_offset < connection->write_length)
+    {
+        int64_t n = send(connection->sd,
+                         connection->write_buffer + connection->write_offset,
+                         connection->write_length - connection->write_offset,
+                         MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return 0;
+            }
+            else if (errno == EINTR)
+            {
+                continue;
+            }
+            return 1;
+        }
+        connection->write_offset += n;
+    }
+
+    // Write queue is empty
+    connection->write_offset = 0;
+    connection->write_length = 0;
+
+    // Success
+    return 0;
+}
+
+static void fail_connection(notifier_t *notifier, customer_connection_t *connection)
+{
+    /* Helper function to close the broken connection. Notifications in flight are kept and sent again,
+       when the connection is restored after the reconnect interval. */
+    LOG_ERROR("Connection to customer %s is lost, %lu notifications are waiting", connection->ip, connection->in_flight_count);
+    epoll_ctl(notifier->epfd, EPOLL_CTL_DEL, connection->sd, NULL);
+    close(connection->sd);
+    connection->sd = -1;
+    connection->is_connected = false;
+    connection->t_retry = get_time_milliseconds() + EXEC_RECONNECT_INTERVAL;
+    connection->write_offset = 0;
+    connection->write_length = 0;
+    connection->read_length = 0;
+}
+
+static uint64_t connect_customer(notifier_t *notifier, customer_connection_t *connection)
+{
+    /* Helper function to start the non-blocking connection to the customer.
+       All notifications in flight are queued again, as it is unknown which of them were received. */
+    struct sockaddr_in customer_addr;
+    memset(&customer_addr, 0, sizeof(customer_addr));
+    customer_addr.sin_family = AF_INET;
+    customer_addr.sin_port = htons(notifier->addr_customer->port);
+    if (inet_pton(AF_INET, connection->ip, &customer_addr.sin_addr) <= 0)
+    {
+        LOG_ERROR("Customer IP address %s is not compatible", connection->ip);
+        return 1;
+    }
+
+    connection->sd = socket(AF_INET, SOCK_STREAM, CUSTOMER_PROTOCOL);
+    int flags = fcntl(connection->sd, F_GETFL, 0);
+    if (connection->sd < 0 || flags < 0 || fcntl(connection->sd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        LOG_ERROR("Unable to create socket for customer %s", connection->ip);
+        if (connection->sd >= 0)
+        {
+            close(connection->sd);
+        }
+        connection->sd = -1;
+        return 2;
+    }
+
+    // Connection is completed, when epoll reports the socket writable
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = connection;
+    if ((connect(connection->sd, (struct sockaddr *)&customer_addr, sizeof(customer_addr)) < 0 && errno != EINPROGRESS) ||
+        epoll_ctl(notifier->epfd, EPOLL_CTL_ADD, connection->sd, &event) < 0)
+    {
+        close(connection->sd);
+        connection->sd = -1;
+        connection->t_retry = get_time_milliseconds() + EXEC_RECONNECT_INTERVAL;
+        return 3;
+    }
+    connection->is_connected = false;
+
+    for (uint64_t position = connection->in_flight_head; position != connection->in_flight_tail; position++)
+    {
+        in_flight_notification_t *in_flight = &connection->in_flight[position & (connection->in_flight_capacity - 1)];
+        if (!in_flight->is_acked && queue_notification_message(connection, &in_flight->notification) != 0)
+        {
+            return 4;
+        }
+    }
+    LOG_DEBUG("Connecting to customer %s", connection->ip);
+
+    // Success
+    return 0;
+}
+
+static customer_connection_t *find_connection(notifier_t *notifier, char *cid, bool *is_unknown)
+{
+    /* Helper function to find the connection to the customer, customers with the same IP share one connection.
+       The connection is resolved once per customer, IP of the new customer is read from Redis. The flag is set,
+       if Redis has no IP of the customer, so the notification can never be delivered. */
+    *is_unknown = false;
+    uint64_t customer_id = find_customer(&notifier->customers, cid);
+    if (customer_id != MAX_CUSTOMERS && notifier->routes[customer_id] != NULL)
+    {
+        return notifier->routes[customer_id];
+    }
+
+    if (customer_id == MAX_CUSTOMERS)
+    {
+        // Replies to the pipelined acknowledgements come first
+        flush_acks(notifier);
+        redisReply *red_rep = redisCommand(notifier->red_con, "HGET %s %s", REDIS_EXCHANGE_C2IP, cid);
+        *is_unknown = red_rep != NULL && red_rep->type == REDIS_REPLY_NIL;
+        if (red_rep == NULL || red_rep->type != REDIS_REPLY_STRING ||
+            (customer_id = intern_customer(&notifier->customers, cid)) == MAX_CUSTOMERS)
+        {
+            freeReplyObject(red_rep);
+            return NULL;
+        }
+        strncpy(notifier->customers.ips[customer_id], red_rep->str, INET_ADDRSTRLEN - 1);
+        freeReplyObject(red_rep);
+    }
+
+    // Find the connection to the IP or create the new one
+    char *ip = notifier->customers.ips[customer_id];
+    customer_connection_t *connection = notifier->connections;
+    while (connection != NULL && strcmp(connection->ip, ip) != 0)
+    {
+        connection = connection->next;
+    }
+    if (connection == NULL)
+    {
+        connection = calloc(1, sizeof(customer_connection_t));
+        if (connection == NULL)
+        {
+            LOG_ERROR("Unable to allocate memory for customer connection");
+            return NULL;
+        }
+        connection->sd = -1;
+        strncpy(connection->ip, ip, INET_ADDRSTRLEN - 1);
+        connection->next = notifier->connections;
+        notifier->connections = connection;
+    }
+    notifier->routes[customer_id] = connection;
+
+    return connection;
+}
+
+static void dispatch_notification(notifier_t *notifier, exec_notification_t *notification)
+{
+    /* Helper function to send the notification over the connection of its customer */
+    bool is_unknown;
+    customer_connection_t *connection = find_connection(notifier, notification->cid, &is_unknown);
+    if (connection == NULL)
+    {
+        // Execution of the unknown customer is acknowledged, otherwise it would stay pending in the stream forever
+        if (is_unknown)
+        {
+            LOG_ERROR("Customer %s of order %lu is unknown, notification is dropped", notification->cid, notification->oid);
+            redisAppendCommand(notifier->red_con, "XACK %s %s %s",
+                               REDIS_EXCHANGE_EXEC_STREAM,
+                               REDIS_EXCHANGE_EXEC_GROUP,
+                               notification->stream_id);
+            notifier->acks++;
+            return;
+        }
+        LOG_ERROR("Unable to find connection to customer %s, order %lu is left pending", notification->cid, notification->oid);
+        return;
+    }
+    char *ip = connection->ip;
+
+    // Notifications over the limit stay pending in the stream and are delivered after the restart
+    if (connection->in_flight_count == EXEC_MAX_IN_FLIGHT)
+    {
+        LOG_ERROR("Too many notifications in flight to customer %s, order %lu is left pending", ip, notification->oid);
+        return;
+    }
+
+    // Acknowledged notifications stay in the ring until the older ones are acknowledged, so the full ring is compacted,
+    // if at least half of it is acknowledged, otherwise it grows. Either way the cost is amortized over the next half.
+    if (connection->in_flight_tail - connection->in_flight_head == connection->in_flight_capacity)
+    {
+        uint64_t capacity = connection->in_flight_capacity == 0 ? 64 : connection->in_flight_capacity;
+        if (connection->in_flight_count * 2 > connection->in_flight_capacity)
+        {
+            capacity *= 2;
+        }
+        if (resize_in_flight(connection, capacity) != 0)
+        {
+            return;
+        }
+    }
+    push_in_flight(connection, notification);
+
+    // New connection queues all notifications in flight, otherwise the notification is added to the open one
+    if (connection->sd < 0)
+    {
+        if (connection->t_retry == 0 && connect_customer(notifier, connection) != 0)
+        {
+            LOG_ERROR("Unable to connect to customer %s", ip);
+        }
+        return;
+    }
+    if (queue_notification_message(connection, notification) != 0 ||
+        (connection->is_connected && flush_connection(connection) != 0))
+    {
+        fail_connection(notifier, connection);
+    }
+}
+
+static void refresh_routes(notifier_t *notifier, customer_connection_t *connection)
+{
+    /* Helper function to read IPs of the customers routed to the failed connection again, before it is restored.
+       Customers, whose IP has changed, are routed again, and their notifications in flight move with them. */
+    bool is_changed = false;
+    flush_acks(notifier);
+    for (uint64_t customer_id = 0; customer_id < notifier->customers.customers; customer_id++)
+    {
+        if (notifier->routes[customer_id] != connection)
+        {
+            continue;
+        }
+        redisReply *red_rep = redisCommand(notifier->red_con, "HGET %s %s", REDIS_EXCHANGE_C2IP, notifier->customers.cids[customer_id]);
+        if (red_rep != NULL && red_rep->type == REDIS_REPLY_STRING && strcmp(red_rep->str, connection->ip) != 0)
+        {
+            LOG_INFO("Customer %s has moved from %s to %s", notifier->customers.cids[customer_id], connection->ip, red_rep->str);
+            memset(notifier->customers.ips[customer_id], 0, INET_ADDRSTRLEN);
+            strncpy(notifier->customers.ips[customer_id], red_rep->str, INET_ADDRSTRLEN - 1);
+            notifier->routes[customer_id] = NULL;
+            is_changed = true;
+        }
+        freeReplyObject(red_rep);
+    }
+    if (!is_changed || connection->in_flight_count == 0)
+    {
+        return;
+    }
+
+    // Notifications in flight are dispatched again in the same sequence, the ones of the moved customers go to their new connections
+    uint64_t count = connection->in_flight_count;
+    exec_notification_t *notifications = malloc(count * sizeof(exec_notification_t));
+    if (notifications == NULL)
+    {
+        LOG_ERROR("Unable to allocate memory for notifications in flight");
+        return;
+    }
+    uint64_t i = 0;
+    for (uint64_t position = connection->in_flight_head; position != connection->in_flight_tail; position++)
+    {
+        in_flight_notification_t *in_flight = &connection->in_flight[position & (connection->in_flight_capacity - 1)];
+        if (!in_flight->is_acked)
+        {
+            notifications[i++] = in_flight->notification;
+        }
+    }
+    memset(connection->in_flight_index, 0, connection->in_flight_capacity * 2 * sizeof(in_flight_entry_t));
+    connection->in_flight_head = 0;
+    connection->in_flight_tail = 0;
+    connection->in_flight_count = 0;
+    for (i = 0; i < count; i++)
+    {
+        dispatch_notification(notifier, &notifications[i]);
+    }
+    free(notifications);
+}
+
+static uint64_t read_acks(notifier_t *notifier, customer_connection_t *connection)
+{
+    /* Helper function to read acknowledgements of the customer and to match them with notifications in flight */
+    while (1)
+    {
+        int64_t n = recv(connection->sd,
+                         connection->read_buffer + connection->read_length,
+                         sizeof(connection->read_buffer) - connection->read_length,
+                         0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return 0;
+        }
+        if (n <= 0)
+        {
+            return 1;
+        }
+        connection->read_length += n;
+
+        // Process all complete acknowledgements, incomplete one stays at the start of the buffer
+        uint64_t offset = 0;
+        while (connection->read_length - offset >= sizeof(order_gateway_response_message_t))
+        {
+            order_gateway_response_message_t ogm_input;
+            memcpy(&ogm_input, connection->read_buffer + offset, sizeof(ogm_input));
+            offset += sizeof(ogm_input);
+            ogm_input.order_id = bswap_64(ogm_input.order_id);
+            ogm_input.ts_ack = bswap_64(ogm_input.ts_ack);
+
+            // Acknowledgement belongs to the oldest notification of the order in flight
+            uint64_t slot = connection->in_flight_count > 0 ? find_in_flight_slot(connection, ogm_input.order_id) : 0;
+            if (connection->in_flight_count == 0 || ogm_input.order_id == 0 || connection->in_flight_index[slot].oid == 0)
+            {
+                LOG_ERROR("Customer %s acknowledged unknown order %lu", connection->ip, ogm_input.order_id);
+                continue;
+            }
+            in_flight_entry_t *entry = &connection->in_flight_index[slot];
+            in_flight_notification_t *in_flight = &connection->in_flight[entry->first & (connection->in_flight_capacity - 1)];
+
+            // Wrong acknowledgement leaves the execution pending in the stream
+            exec_notification_t *notification = &in_flight->notification;
+            if (ogm_input.status == 'A' && ogm_input.ts_ack > notification->t_exec)
+            {
+                redisAppendCommand(notifier->red_con, "XACK %s %s %s",
+                                   REDIS_EXCHANGE_EXEC_STREAM,
+                                   REDIS_EXCHANGE_EXEC_GROUP,
+                                   notification->stream_id);
+                notifier->acks++;
+                LOG_INFO("Customer %s acknowledged execution of order %lu", connection->ip, ogm_input.order_id);
+            }
+            else
+            {
+                LOG_ERROR("Customer %s acknowledgement of order %lu doesn't match the notification", connection->ip, ogm_input.order_id);
+            }
+
+            // Notification is marked instead of removed, the ring is only advanced past the acknowledged ones at its head
+            in_flight->is_acked = true;
+            connection->in_flight_count--;
+            if (entry->first == entry->last)
+            {
+                remove_in_flight_entry(connection, slot);
+            }
+            else
+            {
+                entry->first = in_flight->next;
+            }
+            while (connection->in_flight_head != connection->in_flight_tail &&
+                   connection->in_flight[connection->in_flight_head & (connection->in_flight_capacity - 1)].is_acked)
+            {
+                connection->in_flight_head++;
+            }
+        }
+        memmove(connection->read_buffer, connection->read_buffer + offset, connection->read_length - offset);
+        connection->read_length -= offset;
+    }
+}
+
+static void process_connection_event(notifier_t *notifier, customer_connection_t *connection, uint32_t events)
+{
+    /* Helper function to complete the connection, to read acknowledgements and to send queued notifications */
+    if (connection->sd < 0)
+    {
+        return;
+    }
+
+    // Check result of the non-blocking connect
+    if (!connection->is_connected && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+    {
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        if (getsockopt(connection->sd, SOL_SOCKET, SO_ERROR, &error, &error_len) < 0 || error != 0)
+        {
+            fail_connection(notifier, connection);
+            return;
+        }
+        connection->is_connected = true;
+        LOG_INFO("Connected to customer %s", connection->ip);
+    }
+
+    if ((events & EPOLLIN) && read_acks(notifier, connection) != 0)
+    {
+        fail_connection(notifier, connection);
+        return;
+    }
+
+    if ((events & (EPOLLERR | EPOLLHUP)) || flush_connection(connection) != 0)
+    {
+        fail_connection(notifier, connection);
+    }
+}
+
+uint64_t start_notifier(notifier_t *notifier, redisContext *red_con, redisContext *red_con_reader, server_t *addr_customer)
+{
+    /* Helper function to prepare the event loop and to start the reader thread */
+    memset(notifier, 0, sizeof(notifier_t));
+    notifier->red_con = red_con;
+    notifier->red_con_reader = red_con_reader;
+    notifier->addr_customer = addr_customer;
+    deserialize_customers_redis(red_con, REDIS_EXCHANGE_C2IP, &notifier->customers);
+
+    if (init_spsc_ring(&notifier->ring, EXEC_RING_SIZE, sizeof(exec_notification_t)) != 0)
+    {
+        return 1;
+    }
+
+    notifier->epfd = epoll_create1(0);
+    notifier->event_fd = eventfd(0, EFD_NONBLOCK);
+    if (notifier->epfd < 0 || notifier->event_fd < 0)
+    {
+        perror("Error: Cannot create event loop: ");
+        return 2;
+    }
+
+    // Event of the ring is the only one with the empty pointer
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(notifier->epfd, EPOLL_CTL_ADD, notifier->event_fd, &event) < 0)
+    {
+        perror("Error: Cannot add event to the event loop: ");
+        return 3;
+    }
+
+    if (pthread_create(&notifier->reader, NULL, exec_reader_worker, notifier) != 0)
+    {
+        perror("Error: Cannot start reader thread: ");
+        return 4;
+    }
+
+    // Success
+    return 0;
+}
+
+uint64_t run_notifier(notifier_t *notifier)
+{
+    /* Event loop, which dispatches executions from the reader thread and serves connections to customers */
+    struct epoll_event events[EXEC_MAX_EVENTS];
+    while (1)
+    {
+        // Wake up periodically only while there are connections to restore
+        int timeout = -1;
+        for (customer_connection_t *connection = notifier->connections; connection != NULL; connection = connection->next)
+        {
+            if (connection->sd < 0 && connection->in_flight_count > 0)
+            {
+                timeout = EXEC_RECONNECT_INTERVAL;
+                break;
+            }
+        }
+
+        int n = epoll_wait(notifier->epfd, events, EXEC_MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR)
+        {
+            perror("Error: Cannot wait for events: ");
+            return 6;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            // Take all executions passed by the reader thread
+            if (events[i].data.ptr == NULL)
+            {
+                uint64_t signal;
+                if (read(notifier->event_fd, &signal, sizeof(signal)) < 0 && errno != EAGAIN)
+                {
+                    LOG_ERROR("Unable to read signal of the reader thread");
+                }
+
+                exec_notification_t notification;
+                while (spsc_ring_pop(&notifier->ring, &notification))
+                {
+                    dispatch_notification(notifier, &notification);
+                }
+            }
+            else
+            {
+                process_connection_event(notifier, events[i].data.ptr, events[i].events);
+            }
+        }
+
+        // Restore failed connections, which have notifications in flight
+        uint64_t now = get_time_milliseconds();
+        for (customer_connection_t *connection = notifier->connections; connection != NULL; connection = connection->next)
+        {
+            if (connection->sd < 0 && connection->in_flight_count > 0 && connection->t_retry <= now)
+            {
+                // Customers may have moved to the new IP while the connection was lost
+                refresh_routes(notifier, connection);
+                if (connection->sd < 0 && connection->in_flight_count > 0 && connect_customer(notifier, connection) != 0)
+                {
+                    LOG_ERROR("Unable to reconnect to customer %s", connection->ip);
+                }
+            }
+        }
+
+        // Acknowledge confirmed executions in Redis with one round trip
+        flush_acks(notifier);
+    }
+
+    return 0;
+}
\ No newline at end of file
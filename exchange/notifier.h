@@ -0,0 +1,12 @@
+/* This file contains header for the execution notifier, which keeps persistent connections to customers in exec */
+
+// Preprocessor directives
+#include <stdint.h>
+#include <hiredis/hiredis.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t start_notifier(notifier_t *notifier, redisContext *red_con, redisContext *red_con_reader, server_t *addr_customer);
+uint64_t run_notifier(notifier_t *notifier);
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <time.h>
 #include <hiredis/hiredis.h>
 
@@ -10,7 +11,14 @@
 #include "helper.h"
 #include "comm.h"
 #include "matching_engine.h"
+#include "symbol_directory.h"
+#include "pool.h"
 #include "serializers.h"
+#include "persistence.h"
+#include "journal.h"
+#include "md_publisher.h"
+#include "retransmit.h"
+#include "log.h"
 
 // Main function
 int main(void)
@@ -22,8 +30,19 @@ int main(void)
     // Initialize matching engine
     uint64_t orders = 0; // Later this will be reading existing order queue from Redis
 
-    // Initialize trading trie
-    trading_trie_t *tt = add_node_to_trie('\0');
+    // Create symbol directory and order books
+    matching_engine_t *me = create_matching_engine();
+    if (me == NULL)
+    {
+        return 18;
+    }
+
+    // Intern the symbol universe at the start of the session, if it is provided
+    char *symbols_file = getenv("EXCHANGE_SYMBOLS_FILE");
+    if (symbols_file != NULL)
+    {
+        printf("%lu: Loaded %lu symbols\n", time(NULL), load_symbols(&me->symbols, symbols_file));
+    }
 
     // Open connection to Redis
     redisContext *red_con = redisConnect(addr_redis->ip, addr_redis->port);
@@ -34,47 +53,153 @@ int main(void)
     }
     printf("%lu: Connected to Redis\n", time(NULL));
 
-    // Read orders from Redis
-    order_t *order = deserialize_order_redis(red_con, REDIS_EXCHANGE_A_ORDERS);
+    // Open the journal of orders, if it is configured
+    static journal_t journal;
+    char *journal_path = getenv("EXCHANGE_JOURNAL_PATH");
+    if (journal_path != NULL && open_journal(&journal, journal_path) != 0)
+    {
+        return 22;
+    }
 
-    // Load orders read from Redis in Trading Trie
-    order_t *head = order;
-    while (head)
+    // Rebuild order books from the latest snapshot and the journal after it, which is much faster than reading
+    // orders from Redis one by one
+    if (journal_path != NULL && journal.header->length > 0)
+    {
+        if (load_snapshot(&journal, me, &orders) != 0 || replay_journal(&journal, me, &orders) != 0)
+        {
+            return 18;
+        }
+        printf("%lu: Replayed %lu orders from journal\n", time(NULL), journal.header->length - journal.snapshot_length);
+    }
+    else
     {
-        // Create temp pointer to be able to NULL the next field
-        order_t *temp_order = head;
+        // Read orders from Redis
+        order_t *order = deserialize_order_redis(red_con, REDIS_EXCHANGE_A_ORDERS);
 
-        // Page head and NULL next in temp_order, which is added to trie
-        head = head->next;
-        temp_order->next = NULL;
+        // Load orders read from Redis in the order books
+        order_t *head = order;
+        while (head)
+        {
+            // Create temp pointer to be able to NULL the next field
+            order_t *temp_order = head;
 
-        // Load item to the trading trie with flag init=true to avoid re-loading orders to Redis
-        match_trade(tt, temp_order, red_con, true);
+            // Page head and NULL next in temp_order, which is added to order book
+            head = head->next;
+            temp_order->next = NULL;
+            temp_order->symbol_id = intern_symbol(&me->symbols, temp_order->symbol);
 
-        // Set orders num to the vaule of the last existing
-        if (head == NULL)
-        {
-            orders = temp_order->oid;
+            // Move order to the pool of the matching engine, which owns the orders in the book
+            order_t *pooled_order = pool_alloc(&me->orders);
+            if (pooled_order == NULL)
+            {
+                return 18;
+            }
+            memcpy(pooled_order, temp_order, sizeof(order_t));
+
+            // Set orders num to the biggest existing id, orders are sequenced by price, not by id
+            if (temp_order->oid > orders)
+            {
+                orders = temp_order->oid;
+            }
+            free(temp_order);
+
+            // Start the new journal from the orders in Redis, so that it can be replayed on its own
+            if (journal_path != NULL && append_journal(&journal, pooled_order) != 0)
+            {
+                return 22;
+            }
+
+            // Load item to the order book with flag init=true to avoid re-loading orders to Redis
+            match_trade(me, pooled_order, true);
         }
     }
 
+    // Filled and cancelled orders aren't in the books, so the ids continue from the highest one ever persisted
+    uint64_t last_oid = deserialize_last_oid_redis(red_con, REDIS_EXCHANGE_LAST_OID);
+    if (last_oid > orders)
+    {
+        orders = last_oid;
+    }
+    me->journal = journal_path != NULL ? &journal : NULL;
+
     printf("Next order ID is: %lu\n", orders);
 
-    // Initialize customer's IP to CID mapping
-    cid_ip_t *cid_ip_map = malloc(sizeof(cid_ip_t));
-    cid_ip_map->cid = calloc(37, sizeof(char));
-    cid_ip_map->ip = calloc(16, sizeof(char));
-    cid_ip_map->next = NULL;
+    // Load customer's CID to IP mapping, only new customers and changed IPs are written back to Redis
+    static customer_directory_t customers;
+    printf("%lu: %lu customers are loaded\n", time(NULL), deserialize_customers_redis(red_con, REDIS_EXCHANGE_C2IP, &customers));
 
     // Print welcome message
     printf("%lu: Exchange Order Server started!\n", time(NULL));
     printf("%lu: So far %lu orders to match\n", time(NULL), orders);
 
+    // Start the background logging, so that the hot path doesn't wait for stdout
+    if (log_init() != 0)
+    {
+        return 20;
+    }
+
+    // Start the persistence thread, from now on it owns the connection to Redis
+    static persistence_t persistence;
+    if (start_persistence(&persistence, red_con) != 0)
+    {
+        return 21;
+    }
+    me->persistence = &persistence.ring;
+
+    // Start the Last Sale channel, if it is configured, trades are sent by the matching engine as they are matched
+    static md_publisher_t last_sale;
+    static md_retransmit_t last_sale_retransmit;
+    if (getenv("EXCHANGE_TAPE_LAST_SALE_IP") != NULL)
+    {
+        server_t *addr_last_sale = get_server("EXCHANGE_TAPE_LAST_SALE_IP", "EXCHANGE_TAPE_LAST_SALE_PORT", EXCHANGE_MCAST_PROTOCOL);
+        server_t *addr_mcast_source = get_server("EXCHANGE_TAPE_SOURCE_IP", "EXCHANGE_TAPE_LAST_SALE_PORT", EXCHANGE_MCAST_PROTOCOL);
+        server_t *addr_rewind = get_server("EXCHANGE_TAPE_REWIND_IP", "EXCHANGE_TAPE_LAST_SALE_REWIND_PORT", IPPROTO_TCP);
+
+        uint64_t max_delay = MD_MAX_DELAY_US;
+        char *max_delay_env = getenv("EXCHANGE_MD_MAX_DELAY_US");
+        if (max_delay_env != NULL)
+        {
+            max_delay = strtoul(max_delay_env, NULL, 10);
+        }
+
+        // Session is named by the start time, so that clients can tell the restarted feed by it
+        char session[MD_SESSION_LEN + 1];
+        snprintf(session, sizeof(session), "%010lu", (uint64_t)time(NULL));
+        if (open_md_publisher(&last_sale, addr_last_sale, addr_mcast_source, session, max_delay) != 0 ||
+            start_retransmit(&last_sale_retransmit, addr_rewind, session) != 0)
+        {
+            return 23;
+        }
+        last_sale.retransmit = &last_sale_retransmit;
+        if (publish_system_event(&last_sale, MD_SYSTEM_START, get_time_nanoseconds_since_midnight(get_time_nanoseconds_midnight())) != 0 ||
+            flush_md_packets(&last_sale) != 0)
+        {
+            return 23;
+        }
+        me->last_sale = &last_sale;
+        printf("%lu: Sending trades at %s @ %lu in session %s, retransmission at %s @ %lu\n",
+               time(NULL),
+               addr_last_sale->ip,
+               addr_last_sale->port,
+               session,
+               addr_rewind->ip,
+               addr_rewind->port);
+
+        free(addr_last_sale);
+        free(addr_mcast_source);
+        free(addr_rewind);
+    }
+
     // Launch the server to recive orders
-    receive_orders(addr_order, orders, tt, cid_ip_map, red_con);
+    receive_orders(addr_order, orders, me, &customers);
 
     // Cleanup
-    free_trie(tt);
+    stop_persistence(&persistence);
+    if (journal_path != NULL)
+    {
+        close_journal(&journal);
+    }
+    free_matching_engine(me);
     redisFree(red_con);
     free(addr_redis);
 }
\ No newline at end of file
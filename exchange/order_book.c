@@ -0,0 +1,246 @@
+/* This file contains the price-level order book: sorted price levels with FIFO queue of orders per level */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+// Local headers
+#include "order_book.h"
+#include "pool.h"
+#include "log.h"
+
+// Define aux functions
+static bool is_price_better(book_side_t *side, price_t a, price_t b)
+{
+    /* Helper function to check if price `a` is better than price `b` for the side of the book.
+       Buy side prefers higher prices, sell side prefers lower prices. */
+    return side->operation == 1 ? a > b : a < b;
+}
+
+static uint64_t find_level_index(book_side_t *side, price_t price)
+{
+    /* Helper function to find the position of the price in the side of the book.
+       Levels are sorted from the worst to the best price, so the best one is always the last.
+       Returns the index of the first level, which is not worse than the price. */
+    uint64_t lo = 0;
+    uint64_t hi = side->depth;
+
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (is_price_better(side, price, side->levels[mid]->price))
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+void init_book_side(book_side_t *side, uint64_t operation, pool_t *levels_pool)
+{
+    /* Helper function to initialize empty side of the book, price levels are taken from the pool */
+    side->operation = operation;
+    side->depth = 0;
+    side->capacity = 0;
+    side->levels = NULL;
+    side->levels_pool = levels_pool;
+}
+
+price_level_t *get_best_level(book_side_t *side)
+{
+    /* Helper function to get the best price level of the side of the book in O(1) */
+    if (side->depth == 0)
+    {
+        return NULL;
+    }
+
+    return side->levels[side->depth - 1];
+}
+
+bool is_price_crossing(book_side_t *side, price_level_t *level, price_t price)
+{
+    /* Helper function to check if the opposite order with the price can trade against the level.
+       Sell levels are crossed by buy price higher than or equal to the level, buy levels are crossed
+       by sell price lower than or equal to the level. */
+    return !is_price_better(side, price, level->price);
+}
+
+uint64_t add_order_to_book(book_side_t *side, order_t *order)
+{
+    /* Helper function to add order to the end of the FIFO queue of its price level.
+       The level is created if it doesn't exist yet. */
+
+    // Find position of the price level
+    uint64_t i = find_level_index(side, order->price);
+
+    // Create new level, if there is no one with such price
+    if (i == side->depth || side->levels[i]->price != order->price)
+    {
+        // Grow the list of the levels if needed
+        if (side->depth == side->capacity)
+        {
+            uint64_t capacity = side->capacity == 0 ? BOOK_INITIAL_DEPTH : side->capacity * 2;
+            price_level_t **levels = realloc(side->levels, capacity * sizeof(price_level_t *));
+            if (levels == NULL)
+            {
+                LOG_ERROR("Unable to allocate memory for price levels");
+                return 1;
+            }
+            side->levels = levels;
+            side->capacity = capacity;
+        }
+
+        price_level_t *level = pool_alloc(side->levels_pool);
+        if (level == NULL)
+        {
+            LOG_ERROR("Unable to allocate memory for price level");
+            return 1;
+        }
+        level->price = order->price;
+
+        // Shift worse levels to keep the list sorted
+        memmove(&side->levels[i + 1], &side->levels[i], (side->depth - i) * sizeof(price_level_t *));
+        side->levels[i] = level;
+        side->depth++;
+    }
+
+    // Add order to the end of the queue
+    price_level_t *level = side->levels[i];
+    order->level = level;
+    order->next = NULL;
+    order->previous = level->tail;
+
+    if (level->tail == NULL)
+    {
+        level->head = order;
+    }
+    else
+    {
+        level->tail->next = order;
+    }
+    level->tail = order;
+
+    // Update aggregates
+    level->quantity += order->quantity;
+    level->orders++;
+
+    // Success
+    return 0;
+}
+
+void remove_order_from_book(book_side_t *side, order_t *order)
+{
+    /* Helper function to unlink order from its price level.
+       The level is removed from the book once it has no orders. */
+    price_level_t *level = order->level;
+
+    // Relinking the right part of the node
+    if (order->next != NULL)
+    {
+        order->next->previous = order->previous;
+    }
+    else
+    {
+        level->tail = order->previous;
+    }
+
+    // Relinking the left part of the node
+    if (order->previous != NULL)
+    {
+        order->previous->next = order->next;
+    }
+    else
+    {
+        level->head = order->next;
+    }
+
+    // Update aggregates
+    level->quantity -= order->quantity;
+    level->orders--;
+
+    order->level = NULL;
+    order->next = NULL;
+    order->previous = NULL;
+
+    // Remove the empty level, which in most cases is the best one
+    if (level->orders == 0)
+    {
+        uint64_t i = side->depth - 1;
+        if (side->levels[i] != level)
+        {
+            i = find_level_index(side, level->price);
+        }
+
+        memmove(&side->levels[i], &side->levels[i + 1], (side->depth - i - 1) * sizeof(price_level_t *));
+        side->depth--;
+        pool_free(side->levels_pool, level);
+    }
+}
+
+void replace_order_in_book(order_t *order, order_t *replacement)
+{
+    /* Helper function to put the replacement in place of the resting order at the same price level,
+       so that it keeps the time priority. Quantity of the replacement must not be greater than of the order. */
+    price_level_t *level = order->level;
+
+    replacement->level = level;
+    replacement->next = order->next;
+    replacement->previous = order->previous;
+
+    // Relinking the neighbours to the replacement
+    if (order->next != NULL)
+    {
+        order->next->previous = replacement;
+    }
+    else
+    {
+        level->tail = replacement;
+    }
+    if (order->previous != NULL)
+    {
+        order->previous->next = replacement;
+    }
+    else
+    {
+        level->head = replacement;
+    }
+
+    // Update aggregates
+    level->quantity -= order->quantity - replacement->quantity;
+
+    order->level = NULL;
+    order->next = NULL;
+    order->previous = NULL;
+}
+
+uint64_t fill_order_in_book(book_side_t *side, order_t *order, uint64_t quantity)
+{
+    /* Helper function to execute the quantity of the resting order.
+       The order is removed from the book once it is fully filled. Returns the remaining quantity. */
+    order->level->quantity -= quantity;
+    order->quantity -= quantity;
+
+    if (order->quantity == 0)
+    {
+        remove_order_from_book(side, order);
+    }
+
+    return order->quantity;
+}
+
+void free_book_side(book_side_t *side)
+{
+    /* Helper function to clean up the memory used by the side of the book.
+       Price levels and resting orders are released together with their pools. */
+    free(side->levels);
+    init_book_side(side, side->operation, side->levels_pool);
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+/* This file contains header for the price-level order book kept per symbol in the matching engine */
+
+// Preprocessor directives
+#include <stdint.h>
+#include <stdbool.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+void init_book_side(book_side_t *side, uint64_t operation, pool_t *levels_pool);
+price_level_t *get_best_level(book_side_t *side);
+bool is_price_crossing(book_side_t *side, price_level_t *level, price_t price);
+uint64_t add_order_to_book(book_side_t *side, order_t *order);
+void remove_order_from_book(book_side_t *side, order_t *order);
+void replace_order_in_book(order_t *order, order_t *replacement);
+uint64_t fill_order_in_book(book_side_t *side, order_t *order, uint64_t quantity);
+void free_book_side(book_side_t *side);
\ No newline at end of file
@@ -0,0 +1,158 @@
+/* This file contains the index of resting orders: open-addressing hash table with linear probing from
+   order id to the order in the book. Order ids are sequential, so they are used as the hash directly. */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Local headers
+#include "order_index.h"
+#include "log.h"
+
+// Define aux functions
+static void insert_entry(order_index_t *index, uint64_t oid, order_t *order)
+{
+    /* Helper function to put the entry to the first free slot starting from the hashed one */
+    uint64_t mask = index->capacity - 1;
+    uint64_t slot = oid & mask;
+    while (index->entries[slot].oid != 0 && index->entries[slot].oid != oid)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    if (index->entries[slot].oid == 0)
+    {
+        index->count++;
+    }
+    index->entries[slot].oid = oid;
+    index->entries[slot].order = order;
+}
+
+static uint64_t grow_order_index(order_index_t *index)
+{
+    /* Helper function to double the size of the table and to rehash all entries */
+    order_index_entry_t *entries = index->entries;
+    uint64_t capacity = index->capacity;
+
+    index->entries = calloc(capacity * 2, sizeof(order_index_entry_t));
+    if (index->entries == NULL)
+    {
+        LOG_ERROR("Unable to allocate memory for order index");
+        index->entries = entries;
+        return 1;
+    }
+    index->capacity = capacity * 2;
+    index->count = 0;
+
+    for (uint64_t i = 0; i < capacity; i++)
+    {
+        if (entries[i].oid != 0)
+        {
+            insert_entry(index, entries[i].oid, entries[i].order);
+        }
+    }
+    free(entries);
+
+    // Success
+    return 0;
+}
+
+uint64_t init_order_index(order_index_t *index, uint64_t capacity)
+{
+    /* Helper function to initialize empty index, capacity must be power of two */
+    index->capacity = capacity;
+    index->count = 0;
+    index->entries = calloc(capacity, sizeof(order_index_entry_t));
+    if (index->entries == NULL)
+    {
+        LOG_ERROR("Unable to allocate memory for order index");
+        return 1;
+    }
+
+    // Success
+    return 0;
+}
+
+uint64_t add_order_to_index(order_index_t *index, order_t *order)
+{
+    /* Helper function to add the resting order to the index. The table is kept at most half full. */
+    if ((index->count + 1) * 2 > index->capacity && grow_order_index(index) != 0)
+    {
+        return 1;
+    }
+    insert_entry(index, order->oid, order);
+
+    // Success
+    return 0;
+}
+
+order_t *find_order_in_index(order_index_t *index, uint64_t oid)
+{
+    /* Helper function to find the resting order by its id. Returns `NULL` if it is not in the book. */
+    if (oid == 0)
+    {
+        return NULL;
+    }
+
+    uint64_t mask = index->capacity - 1;
+    uint64_t slot = oid & mask;
+    while (index->entries[slot].oid != 0)
+    {
+        if (index->entries[slot].oid == oid)
+        {
+            return index->entries[slot].order;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return NULL;
+}
+
+void remove_order_from_index(order_index_t *index, uint64_t oid)
+{
+    /* Helper function to remove the order from the index. Following entries of the same cluster are shifted back,
+       so that lookups never need tombstones. */
+    uint64_t mask = index->capacity - 1;
+    uint64_t slot = oid & mask;
+    while (index->entries[slot].oid != oid)
+    {
+        if (index->entries[slot].oid == 0)
+        {
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // Shift back entries, which would become unreachable
+    uint64_t next = slot;
+    while (1)
+    {
+        next = (next + 1) & mask;
+        if (index->entries[next].oid == 0)
+        {
+            break;
+        }
+
+        // Entry can be moved to the free slot only if its home slot is not between the free slot and itself
+        uint64_t home = index->entries[next].oid & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            index->entries[slot] = index->entries[next];
+            slot = next;
+        }
+    }
+    index->entries[slot].oid = 0;
+    index->entries[slot].order = NULL;
+    index->count--;
+}
+
+void free_order_index(order_index_t *index)
+{
+    /* Helper function to clean up the memory used by the index */
+    free(index->entries);
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
\ No newline at end of file
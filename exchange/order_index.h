@@ -0,0 +1,14 @@
+/* This file contains header for the index of resting orders by order id used for cancel and replace */
+
+// Preprocessor directives
+#include <stdint.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t init_order_index(order_index_t *index, uint64_t capacity);
+uint64_t add_order_to_index(order_index_t *index, order_t *order);
+order_t *find_order_in_index(order_index_t *index, uint64_t oid);
+void remove_order_from_index(order_index_t *index, uint64_t oid);
+void free_order_index(order_index_t *index);
\ No newline at end of file
@@ -0,0 +1,212 @@
+/* This file contains the persistence thread: the matching thread publishes order, cancel, execution and customer
+   events to the single-producer/single-consumer ring, the persistence thread drains it and writes them to Redis
+   in pipelined batches, so that Redis latency never becomes matching latency. Changes of the resting orders are
+   also added to the stream of book events, which market_data sends to customers as deltas. */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <hiredis/hiredis.h>
+
+// Local headers
+#include "persistence.h"
+#include "spsc_ring.h"
+#include "helper.h"
+#include "log.h"
+
+// Define aux functions
+static void write_book_event(redisContext *red_con, char type, order_t *order, uint64_t quantity, uint64_t leaves, price_t price,
+                             uint64_t t_server, uint64_t match_id)
+{
+    /* Helper function to publish the change of the resting order for market data.
+       Quantity and price are of the change itself: rested, filled at the fill price or cancelled.
+       Leaves is the quantity of the order remaining in the book after the change, match id is set for fills only. */
+    book_event_t book_event;
+    book_event.type = type;
+    book_event.oid = order->oid;
+    memcpy(book_event.symbol, order->symbol, sizeof(book_event.symbol));
+    book_event.operation = order->operation;
+    book_event.price = price;
+    book_event.quantity = quantity;
+    book_event.leaves = leaves;
+    book_event.t_server = t_server;
+    book_event.match_id = match_id;
+    add_book_event_to_redis(red_con, &book_event);
+}
+
+static void write_event(redisContext *red_con, persistence_event_t *event)
+{
+    /* Helper function to append Redis commands for the event to the pipeline */
+    if (event->type == PERSIST_ORDER)
+    {
+        add_order_to_redis(red_con, &event->order);
+        write_book_event(red_con, MD_EVENT_ADD, &event->order, event->order.quantity, event->order.quantity, event->order.price,
+                         event->order.t_server, 0);
+    }
+    else if (event->type == PERSIST_ORDER_DETAILS)
+    {
+        add_order_to_redis_details(red_con, &event->order);
+    }
+    else if (event->type == PERSIST_CANCEL)
+    {
+        remove_order_from_redis(red_con, &event->order);
+
+        // Cancel has no timestamp of its own, so it is stamped when it is written
+        write_book_event(red_con, MD_EVENT_CANCEL, &event->order, event->order.quantity, 0, event->order.price,
+                         get_time_nanoseconds_since_midnight(get_time_nanoseconds_midnight()), 0);
+    }
+    else if (event->type == PERSIST_EXECUTION)
+    {
+        event->execution.next = NULL;
+        move_orders_to_exec_queue_redis(red_con, &event->execution);
+
+        // Only the resting order is in the book, it is on the opposite side of the aggressor
+        order_t resting_order;
+        resting_order.oid = event->execution.resting_oid;
+        memcpy(resting_order.symbol, event->execution.symbol, sizeof(resting_order.symbol));
+        resting_order.operation = event->execution.operation == 1 ? 0 : 1;
+        write_book_event(red_con, MD_EVENT_EXECUTE, &resting_order, event->execution.quantity, event->execution.resting_leaves,
+                         event->execution.price, event->execution.t_server, event->execution.match_id);
+    }
+    else if (event->type == PERSIST_CUSTOMER)
+    {
+        add_cid_ip_to_redis(red_con, event->customer.cid, event->customer.ip);
+    }
+    else
+    {
+        LOG_ERROR("Unknown persistence event '%lu'", event->type);
+    }
+}
+
+static uint64_t get_event_oid(persistence_event_t *event)
+{
+    /* Helper function to get the order id, which the event creates records for in Redis, or `0` if there is none */
+    if (event->type == PERSIST_ORDER || event->type == PERSIST_ORDER_DETAILS || event->type == PERSIST_CANCEL)
+    {
+        return event->order.oid;
+    }
+    if (event->type == PERSIST_EXECUTION)
+    {
+        return event->execution.aggressor_oid;
+    }
+
+    return 0;
+}
+
+static void *persistence_worker(void *arg)
+{
+    /* Persistence thread, which drains the ring and flushes each batch of events with one round trip to Redis */
+    persistence_t *persistence = arg;
+    persistence_event_t event;
+    uint64_t written = 0;
+    uint64_t full_count = 0;
+    uint64_t last_oid = 0;
+    time_t t_stats = time(NULL);
+
+    while (1)
+    {
+        // Take all events published so far
+        uint64_t batch = 0;
+        uint64_t batch_oid = 0;
+        while (batch < REDIS_PIPELINE_DEPTH && spsc_ring_pop(&persistence->ring, &event))
+        {
+            write_event(persistence->red_con, &event);
+            uint64_t oid = get_event_oid(&event);
+            batch_oid = oid > batch_oid ? oid : batch_oid;
+            batch++;
+        }
+
+        if (batch > 0)
+        {
+            // Highest order id is written once per batch, so that ids of filled and cancelled orders aren't reused after the restart
+            if (batch_oid > last_oid)
+            {
+                set_last_oid_to_redis(persistence->red_con, batch_oid);
+                last_oid = batch_oid;
+            }
+            flush_redis_pipeline(persistence->red_con);
+            written += batch;
+        }
+        // Ring is drained, so it is safe to stop
+        else if (atomic_load(&persistence->is_stopping))
+        {
+            break;
+        }
+        else
+        {
+            nanosleep((const struct timespec[]){{0, 100000L}}, NULL);
+        }
+
+        // Report back-pressure metrics periodically, if anything happened
+        if (time(NULL) - t_stats >= PERSISTENCE_STATS_INTERVAL)
+        {
+            uint64_t full_count_now = atomic_load_explicit(&persistence->ring.full_count, memory_order_relaxed);
+            if (written > 0 || full_count_now != full_count)
+            {
+                LOG_INFO("Persistence: %lu events written, queue depth %lu, high watermark %lu of %lu, matching thread waited %lu times",
+                         written,
+                         spsc_ring_depth(&persistence->ring),
+                         atomic_load_explicit(&persistence->ring.high_watermark, memory_order_relaxed),
+                         persistence->ring.capacity,
+                         full_count_now - full_count);
+            }
+            written = 0;
+            full_count = full_count_now;
+            t_stats = time(NULL);
+        }
+    }
+
+    return NULL;
+}
+
+uint64_t start_persistence(persistence_t *persistence, redisContext *red_con)
+{
+    /* Helper function to create the ring and to start the persistence thread, which owns the Redis connection */
+    persistence->red_con = red_con;
+    atomic_init(&persistence->is_stopping, false);
+    if (init_spsc_ring(&persistence->ring, PERSISTENCE_RING_SIZE, sizeof(persistence_event_t)) != 0)
+    {
+        return 1;
+    }
+
+    if (pthread_create(&persistence->thread, NULL, persistence_worker, persistence) != 0)
+    {
+        perror("Error: Cannot start persistence thread: ");
+        free_spsc_ring(&persistence->ring);
+        return 2;
+    }
+
+    // Success
+    return 0;
+}
+
+void persist_event(spsc_ring_t *ring, persistence_event_t *event)
+{
+    /* Helper function to publish the event from the matching thread. State changes are never dropped,
+       so if the ring is full the matching thread waits for the free slot and the wait is counted as back-pressure. */
+    if (spsc_ring_push(ring, event))
+    {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&ring->full_count, 1, memory_order_relaxed);
+    while (!spsc_ring_push(ring, event))
+    {
+        sched_yield();
+    }
+}
+
+void stop_persistence(persistence_t *persistence)
+{
+    /* Helper function to write all published events and to stop the persistence thread */
+    atomic_store(&persistence->is_stopping, true);
+    pthread_join(persistence->thread, NULL);
+    free_spsc_ring(&persistence->ring);
+}
\ No newline at end of file
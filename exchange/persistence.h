@@ -0,0 +1,13 @@
+/* This file contains header for the persistence thread, which writes state changes of the matching engine to Redis */
+
+// Preprocessor directives
+#include <stdint.h>
+#include <hiredis/hiredis.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t start_persistence(persistence_t *persistence, redisContext *red_con);
+void persist_event(spsc_ring_t *ring, persistence_event_t *event);
+void stop_persistence(persistence_t *persistence);
\ No newline at end of file
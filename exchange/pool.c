@@ -0,0 +1,98 @@
+/* This file contains the fixed-size object pool: objects are carved from slabs allocated in bulk
+   and recycled through the free list, so the steady state doesn't touch the heap */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Local headers
+#include "pool.h"
+
+// Define aux functions
+static uint64_t add_slab_to_pool(pool_t *pool)
+{
+    /* Helper function to allocate new slab and add all its objects to the free list */
+    pool_slab_t *slab = calloc(1, sizeof(pool_slab_t) + pool->object_size * pool->slab_objects);
+    if (slab == NULL)
+    {
+        printf("%lu: Unable to allocate memory for pool slab\n", time(NULL));
+        return 1;
+    }
+
+    // Link slab to the list of slabs to release them later
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    // Add objects to the free list in reverse order, so they are handed out in the memory order
+    for (uint64_t i = pool->slab_objects; i > 0; i--)
+    {
+        void **object = (void **)(slab->objects + (i - 1) * pool->object_size);
+        *object = pool->free_list;
+        pool->free_list = object;
+    }
+    pool->capacity += pool->slab_objects;
+
+    // Success
+    return 0;
+}
+
+uint64_t init_pool(pool_t *pool, uint64_t object_size, uint64_t slab_objects)
+{
+    /* Helper function to initialize pool of objects of the same size and pre-allocate the first slab */
+    memset(pool, 0, sizeof(pool_t));
+
+    // Keep objects aligned to 8 bytes and big enough to store link in the free list
+    pool->object_size = (object_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    pool->slab_objects = slab_objects;
+
+    return add_slab_to_pool(pool);
+}
+
+void *pool_alloc(pool_t *pool)
+{
+    /* Helper function to take zeroed object from the pool. Heap is used only once the pool is exhausted. */
+    if (pool->free_list == NULL && add_slab_to_pool(pool) != 0)
+    {
+        return NULL;
+    }
+
+    // Pop object from the free list
+    void **object = pool->free_list;
+    pool->free_list = *object;
+    pool->used++;
+
+    memset(object, 0, pool->object_size);
+
+    return object;
+}
+
+void pool_free(pool_t *pool, void *object)
+{
+    /* Helper function to return object to the pool */
+    if (object == NULL)
+    {
+        return;
+    }
+
+    // Push object to the free list
+    *(void **)object = pool->free_list;
+    pool->free_list = object;
+    pool->used--;
+}
+
+void free_pool(pool_t *pool)
+{
+    /* Helper function to clean up the memory used by all slabs of the pool */
+    pool_slab_t *head = pool->slabs;
+    while (head != NULL)
+    {
+        pool_slab_t *temp = head;
+        head = head->next;
+        free(temp);
+    }
+
+    memset(pool, 0, sizeof(pool_t));
+}
\ No newline at end of file
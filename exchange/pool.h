@@ -0,0 +1,13 @@
+/* This file contains header for the fixed-size object pool used to avoid heap allocations on the order path */
+
+// Preprocessor directives
+#include <stdint.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t init_pool(pool_t *pool, uint64_t object_size, uint64_t slab_objects);
+void *pool_alloc(pool_t *pool);
+void pool_free(pool_t *pool, void *object);
+void free_pool(pool_t *pool);
\ No newline at end of file
@@ -0,0 +1,226 @@
+/* This file contains the retransmission service of market data: the publisher keeps the last messages in the ring,
+   and the rewind thread sends the requested range of them over TCP to the client, which detected the gap in the feed.
+   The ring has the single writer, the reader verifies after the copy that the messages weren't overwritten meanwhile. */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <byteswap.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+
+// Local headers
+#include "retransmit.h"
+#include "log.h"
+
+// Define aux functions
+static uint64_t copy_messages(md_retransmit_t *retransmit, uint64_t sequence, uint64_t count, char *response, uint64_t *first)
+{
+    /* Helper function to copy the range of messages to the response, each message is prefixed with its length.
+       Only messages which are still in the ring are copied, sequence number of the first one is returned in `first`.
+       Returns the length of the response. */
+    uint64_t next_sequence = atomic_load_explicit(&retransmit->next_sequence, memory_order_acquire);
+    uint64_t oldest = next_sequence > MD_RETRANSMIT_RING_SIZE ? next_sequence - MD_RETRANSMIT_RING_SIZE : 1;
+    uint64_t end = sequence + count < next_sequence ? sequence + count : next_sequence;
+    if (sequence < oldest)
+    {
+        sequence = oldest;
+    }
+    if (sequence >= end)
+    {
+        *first = sequence;
+        return 0;
+    }
+    count = end - sequence;
+
+    // Offsets of the messages are kept, so that the overwritten ones can be dropped from the front
+    uint64_t offsets[MD_MAX_RETRANSMIT];
+    uint64_t length = 0;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        uint64_t slot = (sequence + i) & (MD_RETRANSMIT_RING_SIZE - 1);
+        uint16_t message_length = retransmit->lengths[slot];
+        uint16_t length_be = bswap_16(message_length);
+        offsets[i] = length;
+        memcpy(response + length, &length_be, sizeof(length_be));
+        memcpy(response + length + sizeof(length_be), retransmit->messages[slot], message_length);
+        length += sizeof(length_be) + message_length;
+    }
+
+    // Writer could overwrite the oldest messages during the copy
+    atomic_thread_fence(memory_order_acquire);
+    next_sequence = atomic_load_explicit(&retransmit->next_sequence, memory_order_relaxed);
+    uint64_t dropped = 0;
+    while (dropped < count && sequence + dropped + MD_RETRANSMIT_RING_SIZE <= next_sequence)
+    {
+        dropped++;
+    }
+    if (dropped > 0)
+    {
+        uint64_t offset = dropped < count ? offsets[dropped] : length;
+        memmove(response, response + offset, length - offset);
+        length -= offset;
+    }
+    *first = sequence + dropped;
+
+    return length;
+}
+
+static void serve_request(md_retransmit_t *retransmit, int64_t sd)
+{
+    /* Helper function to read the request of the client and to send the requested messages back */
+    md_packet_header_t request;
+    uint64_t received = 0;
+    while (received < sizeof(request))
+    {
+        int64_t n = recv(sd, (char *)&request + received, sizeof(request) - received, 0);
+        if (n <= 0)
+        {
+            LOG_ERROR("Unable to receive retransmission request");
+            return;
+        }
+        received += n;
+    }
+    uint64_t sequence = bswap_64(request.sequence);
+    uint64_t count = bswap_16(request.count);
+    if (count > MD_MAX_RETRANSMIT)
+    {
+        count = MD_MAX_RETRANSMIT;
+    }
+
+    // Messages of the other session are gone, the empty response tells the client the current session
+    static char response[sizeof(md_packet_header_t) + MD_MAX_RETRANSMIT * (sizeof(uint16_t) + MD_MAX_MESSAGE_LEN)];
+    md_packet_header_t *header = (md_packet_header_t *)response;
+    uint64_t first = sequence;
+    uint64_t length = 0;
+    if (memcmp(request.session, retransmit->session, MD_SESSION_LEN) == 0)
+    {
+        length = copy_messages(retransmit, sequence, count, response + sizeof(md_packet_header_t), &first);
+    }
+
+    // Count of messages is known from the sequence numbers, the copied range is contiguous
+    uint64_t copied = 0;
+    for (uint64_t offset = 0; offset < length; copied++)
+    {
+        uint16_t message_length;
+        memcpy(&message_length, response + sizeof(md_packet_header_t) + offset, sizeof(message_length));
+        offset += sizeof(message_length) + bswap_16(message_length);
+    }
+    memcpy(header->session, retransmit->session, MD_SESSION_LEN);
+    header->sequence = bswap_64(first);
+    header->count = bswap_16(copied);
+
+    if (send(sd, response, sizeof(md_packet_header_t) + length, MSG_NOSIGNAL) < 0)
+    {
+        LOG_ERROR("Unable to send retransmission response");
+        return;
+    }
+    LOG_INFO("Retransmitted %lu of %lu messages from %lu", copied, count, sequence);
+}
+
+static void *retransmit_worker(void *arg)
+{
+    /* Rewind thread, which serves retransmission requests one by one, each on its own connection */
+    md_retransmit_t *retransmit = arg;
+    while (1)
+    {
+        struct sockaddr_in client_addr;
+        socklen_t client_addr_len = sizeof(client_addr);
+        int64_t sd = accept(retransmit->sd, (struct sockaddr *)&client_addr, &client_addr_len);
+        if (sd < 0)
+        {
+            LOG_ERROR("Unable to accept retransmission request");
+            continue;
+        }
+
+        // Slow client can't block others for longer than the timeout
+        struct timeval timeout;
+        timeout.tv_sec = MD_REWIND_TIMEOUT;
+        timeout.tv_usec = 0;
+        setsockopt(sd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(sd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        serve_request(retransmit, sd);
+        close(sd);
+    }
+
+    return NULL;
+}
+
+uint64_t start_retransmit(md_retransmit_t *retransmit, server_t *addr_rewind, char *session)
+{
+    /* Helper function to open the TCP server for retransmission requests and to start the rewind thread */
+    memcpy(retransmit->session, session, MD_SESSION_LEN);
+    atomic_init(&retransmit->next_sequence, 1);
+
+    retransmit->sd = socket(AF_INET, SOCK_STREAM, addr_rewind->protocol);
+    if (retransmit->sd < 0)
+    {
+        perror("Error: Cannot create socket: ");
+        return 1;
+    }
+
+    int optval = 1;
+    if (setsockopt(retransmit->sd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0)
+    {
+        perror("Error: Cannot set socket option: ");
+        return 2;
+    }
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(addr_rewind->port);
+    if (inet_pton(AF_INET, addr_rewind->ip, &server_addr.sin_addr) <= 0)
+    {
+        perror("Error: Uncompatible IP Address: ");
+        return 3;
+    }
+
+    if (bind(retransmit->sd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0 || listen(retransmit->sd, SOMAXCONN) < 0)
+    {
+        perror("Error: Cannot listen for retransmission requests: ");
+        return 4;
+    }
+
+    if (pthread_create(&retransmit->thread, NULL, retransmit_worker, retransmit) != 0)
+    {
+        perror("Error: Cannot start rewind thread: ");
+        return 5;
+    }
+
+    // Success
+    return 0;
+}
+
+void store_md_packet(md_retransmit_t *retransmit, char *packet, uint64_t length)
+{
+    /* Helper function to keep messages of the datagram in the ring before it is sent.
+       Messages are published to the rewind thread by the sequence number of the next message. */
+    md_packet_header_t *header = (md_packet_header_t *)packet;
+    uint64_t sequence = bswap_64(header->sequence);
+    uint64_t count = bswap_16(header->count);
+    uint64_t offset = sizeof(md_packet_header_t);
+    for (uint64_t i = 0; i < count && offset + sizeof(uint16_t) <= length; i++)
+    {
+        uint16_t message_length;
+        memcpy(&message_length, packet + offset, sizeof(message_length));
+        message_length = bswap_16(message_length);
+        offset += sizeof(message_length);
+
+        // Slot is reused only after the previous sequence number is published, so the reader can detect it
+        atomic_thread_fence(memory_order_release);
+        uint64_t slot = (sequence + i) & (MD_RETRANSMIT_RING_SIZE - 1);
+        retransmit->lengths[slot] = message_length;
+        memcpy(retransmit->messages[slot], packet + offset, message_length);
+        offset += message_length;
+        atomic_store_explicit(&retransmit->next_sequence, sequence + i + 1, memory_order_release);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+/* This file contains header for the retransmission service of market data, which sends lost messages again over TCP */
+
+// Preprocessor directives
+#include <stdint.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t start_retransmit(md_retransmit_t *retransmit, server_t *addr_rewind, char *session);
+void store_md_packet(md_retransmit_t *retransmit, char *packet, uint64_t length);
\ No newline at end of file
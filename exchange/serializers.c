@@ -2,82 +2,87 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <time.h>
+#include <byteswap.h>
 #include <hiredis/hiredis.h>
 
 // Local code
 #include "serializers.h"
 #include "helper.h"
+#include "pool.h"
+#include "customer_directory.h"
 
 // Define aux functions
-order_t *deserialize_order_wire(char *message, uint64_t oid)
+order_t *deserialize_order_wire(char *message, uint64_t oid, pool_t *pool)
 {
-    // Initialize result
-    order_t *order = calloc(1, sizeof(order_t));
-
-    // Initialize resources for parsing
-    uint64_t n = strlen(message);
+    /* Helper function to parse the colon-delimited order. Layout depends on the operation:
+       - buy/sell: `cid:t_client:op:symbol:qty:price`
+       - cancel:   `cid:t_client:2:oid`
+       - replace:  `cid:t_client:3:oid:qty:price`
+       Returns `NULL` if the order is malformed or there is no memory for it. */
+
+    // Split the message to fields in the local copy
+    char buf[MAX_MSG_LEN];
+    char *fields[ORDER_WIRE_FIELDS];
     uint64_t c = 0;
-    char *buf = calloc(MAX_MSG_LEN, sizeof(char));
-
-    // Parse order
-    uint64_t bi = 0;
-    for (uint64_t i = 0; i < n; i++)
+    strncpy(buf, message, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    fields[c++] = buf;
+    for (char *p = buf; *p != '\0'; p++)
     {
-        // Add the character to the buffer
-        if (message[i] != ':')
-        {
-            buf[bi] = message[i];
-            bi++;
-        }
-        // In case delimiter found
-        else
+        if (*p == ':')
         {
-            // Customer ID
-            if (c == 0)
+            // Terminate the field
+            *p = '\0';
+            if (c == ORDER_WIRE_FIELDS)
             {
-                strncpy(order->cid, buf, 36);
+                return NULL;
             }
-            // Customer timestmap
-            else if (c == 1)
-            {
+            fields[c++] = p + 1;
+        }
+    }
+    if (c < 4)
+    {
+        return NULL;
+    }
 
-                order->t_client = strtol(buf, NULL, 10);
-            }
-            // Operation
-            else if (c == 2)
-            {
-                order->operation = strtol(buf, NULL, 10);
-            }
-            // Symbol
-            else if (c == 3)
-            {
-                memset(order->symbol, '\0', sizeof(order->symbol));
-                uint64_t j = 0;
-                while (buf[j] != '\0')
-                {
-                    order->symbol[j] = buf[j];
-                    j++;
-                }
-            }
-            // Qunatity
-            else if (c == 4)
-            {
-                order->quantity = atoi(buf);
-            }
-            c++;
+    // Operation defines the rest of the fields
+    uint64_t operation = strtoul(fields[2], NULL, 10);
+    if (!((operation <= 1 && c == 6) || (operation == 2 && c == 4) || (operation == 3 && c == 6)))
+    {
+        return NULL;
+    }
 
-            // Reset buffer
-            free(buf);
-            buf = calloc(MAX_MSG_LEN, sizeof(char));
+    // Initialize result from the pool of orders
+    order_t *order = pool_alloc(pool);
+    if (order == NULL)
+    {
+        return NULL;
+    }
 
-            // Reset index for buffer
-            bi = 0;
-        }
+    // Customer ID, timestamp and operation
+    strncpy(order->cid, fields[0], 36);
+    order->t_client = strtoul(fields[1], NULL, 10);
+    order->operation = operation;
+
+    // Symbol or the id of the order to cancel/replace
+    if (operation <= 1)
+    {
+        strncpy(order->symbol, fields[3], sizeof(order->symbol) - 1);
+    }
+    else
+    {
+        order->target_oid = strtoul(fields[3], NULL, 10);
+    }
+
+    // Quantity and price
+    if (c == 6)
+    {
+        order->quantity = strtoul(fields[4], NULL, 10);
+        order->price = parse_price(fields[5]);
     }
-    // Price
-    order->price = strtof(buf, NULL);
 
     // Set server-side data and default fields
     order->oid = oid;
@@ -85,140 +90,341 @@ order_t *deserialize_order_wire(char *message, uint64_t oid)
     order->next = NULL;
     order->previous = NULL;
 
-    // Cleanup
-    free(buf);
+    return order;
+}
+
+order_t *deserialize_order_binary(char *message, uint64_t length, char *cid, uint64_t oid, pool_t *pool)
+{
+    /* Helper function to decode the binary order, cancel or replace, which is read in place from the frame.
+       Customer ID is not part of the message, it is taken from the logon of the session.
+       Returns `NULL` if the length doesn't match the type or there is no memory for it. */
+    if (!((message[0] == ORDER_ENTRY_ORDER && length == sizeof(order_entry_order_message_t)) ||
+          (message[0] == ORDER_ENTRY_CANCEL && length == sizeof(order_entry_cancel_message_t)) ||
+          (message[0] == ORDER_ENTRY_REPLACE && length == sizeof(order_entry_replace_message_t))))
+    {
+        return NULL;
+    }
+
+    // Initialize result from the pool of orders
+    order_t *order = pool_alloc(pool);
+    if (order == NULL)
+    {
+        return NULL;
+    }
+    memcpy(order->cid, cid, sizeof(order->cid));
+
+    // Fixed offsets, so fields are copied directly
+    if (message[0] == ORDER_ENTRY_ORDER)
+    {
+        order_entry_order_message_t *m = (order_entry_order_message_t *)message;
+        order->t_client = bswap_64(m->t_client);
+        order->operation = m->operation;
+        memcpy(order->symbol, m->symbol, SYMBOL_LEN);
+        order->symbol[SYMBOL_LEN] = '\0';
+        order->quantity = bswap_64(m->quantity);
+        order->price = bswap_64(m->price);
+    }
+    else if (message[0] == ORDER_ENTRY_CANCEL)
+    {
+        order_entry_cancel_message_t *m = (order_entry_cancel_message_t *)message;
+        order->t_client = bswap_64(m->t_client);
+        order->operation = 2;
+        order->target_oid = bswap_64(m->order_id);
+    }
+    else
+    {
+        order_entry_replace_message_t *m = (order_entry_replace_message_t *)message;
+        order->t_client = bswap_64(m->t_client);
+        order->operation = 3;
+        order->target_oid = bswap_64(m->order_id);
+        order->quantity = bswap_64(m->quantity);
+        order->price = bswap_64(m->price);
+    }
+
+    // Set server-side data
+    order->oid = oid;
+    order->t_server = get_time_nanoseconds_since_midnight(get_time_nanoseconds_midnight());
 
     return order;
 }
 
+static int compare_orders_priority(const void *a, const void *b)
+{
+    /* Helper function to compare orders by price, then by arrival time and id, which is their priority in the queue */
+    const order_t *order_a = *(order_t *const *)a;
+    const order_t *order_b = *(order_t *const *)b;
+
+    if (order_a->price != order_b->price)
+    {
+        return order_a->price < order_b->price ? -1 : 1;
+    }
+    if (order_a->t_server != order_b->t_server)
+    {
+        return order_a->t_server < order_b->t_server ? -1 : 1;
+    }
+    if (order_a->oid != order_b->oid)
+    {
+        return order_a->oid < order_b->oid ? -1 : 1;
+    }
+    return 0;
+}
+
 order_t *deserialize_order_redis(redisContext *red_con, char *redis_list)
 {
-    /*  Helper function to read orders from Redis */
+    /*  Helper function to read orders from Redis. Details of the orders are requested in pipelined batches
+        instead of one round trip per order, then orders are sequenced by price, arrival time and id,
+        so that the queues of the order books are rebuilt in their original priority. */
 
     // Get list of open orders
     redisReply *red_rep1 = redisCommand(red_con, "HKEYS %s", redis_list);
 
     // Set pointer to null and free it if there are no orders
-    if (red_rep1->elements == 0)
+    if (red_rep1 == NULL || red_rep1->type != REDIS_REPLY_ARRAY || red_rep1->elements == 0)
     {
         freeReplyObject(red_rep1);
         return NULL;
     }
-    // Otherwise, load orders in the linked list
-    else
+
+    order_t **orders = calloc(red_rep1->elements, sizeof(order_t *));
+    if (orders == NULL)
+    {
+        perror("ERROR: Cannot allocate memory\n");
+        exit(1);
+    }
+    uint64_t loaded = 0;
+
+    for (uint64_t i = 0; i < red_rep1->elements; i += REDIS_PIPELINE_DEPTH)
     {
-        // Get head
-        order_t *head = malloc(sizeof(order_t));
-        if (head == NULL)
+        // Request details of the batch of orders
+        uint64_t batch = red_rep1->elements - i < REDIS_PIPELINE_DEPTH ? red_rep1->elements - i : REDIS_PIPELINE_DEPTH;
+        for (uint64_t j = 0; j < batch; j++)
         {
-            perror("ERROR: Cannot allocate memory\n");
-            free(head);
-            exit(1);
+            redisAppendCommand(red_con, "HMGET %s:%s cid t_client t_server symbol op price qty",
+                               REDIS_EXCHANGE_ORDER_PREFIX,
+                               red_rep1->element[i + j]->str);
         }
 
-        // Set char memory for zero
-        memset(head->cid, '\0', 37);
-        memset(head->symbol, '\0', 10);
-
-        // Get tail
-        order_t *tail = head;
-
-        for (uint64_t i = 0; i < red_rep1->elements; i++)
+        // Set order details to structs
+        for (uint64_t j = 0; j < batch; j++)
         {
-            // Get order details from Redis
-            redisReply *red_rep2 = redisCommand(red_con, "HVALS %s:%s",
-                                                REDIS_EXCHANGE_ORDER_PREFIX,
-                                                red_rep1->element[i]->str);
-
-            // Set order details to struct
-            tail->oid = atol(red_rep1->element[i]->str);
-            strncpy(tail->cid, red_rep2->element[0]->str, 36);
-            tail->t_client = atol(red_rep2->element[1]->str);
-            tail->t_server = atol(red_rep2->element[2]->str);
-            strncpy(tail->symbol, red_rep2->element[3]->str, 10);
-            tail->operation = atol(red_rep2->element[4]->str);
-            tail->price = atof(red_rep2->element[5]->str);
-            tail->quantity = atol(red_rep2->element[6]->str);
-            tail->previous = NULL;
-            tail->next = NULL;
-
-            freeReplyObject(red_rep2);
+            redisReply *red_rep2 = NULL;
+            if (redisGetReply(red_con, (void **)&red_rep2) != REDIS_OK)
+            {
+                printf("%lu: Error: Unable to read orders from Redis: %s\n", time(NULL), red_con->errstr);
+                exit(1);
+            }
 
-            // Allocate memory for new node only if this is not the last element
-            if (i != red_rep1->elements - 1)
+            // Skip the order, which has no details
+            bool is_complete = red_rep2->type == REDIS_REPLY_ARRAY && red_rep2->elements == 7;
+            for (uint64_t k = 0; is_complete && k < red_rep2->elements; k++)
+            {
+                is_complete = red_rep2->element[k]->type == REDIS_REPLY_STRING;
+            }
+            if (!is_complete)
             {
-                // Create new end node
-                order_t *new_order = calloc(1, sizeof(order_t));
+                printf("%lu: Order %s has no details, skipped\n", time(NULL), red_rep1->element[i + j]->str);
+                freeReplyObject(red_rep2);
+                continue;
+            }
 
-                //  Update tail to point to new order
-                tail->next = new_order;
-                tail = tail->next;
+            order_t *order = calloc(1, sizeof(order_t));
+            if (order == NULL)
+            {
+                perror("ERROR: Cannot allocate memory\n");
+                exit(1);
             }
-        }
+            order->oid = strtoul(red_rep1->element[i + j]->str, NULL, 10);
+            strncpy(order->cid, red_rep2->element[0]->str, 36);
+            order->t_client = strtoul(red_rep2->element[1]->str, NULL, 10);
+            order->t_server = strtoul(red_rep2->element[2]->str, NULL, 10);
+            strncpy(order->symbol, red_rep2->element[3]->str, 10);
+            order->operation = strtoul(red_rep2->element[4]->str, NULL, 10);
+            order->price = strtoul(red_rep2->element[5]->str, NULL, 10);
+            order->quantity = strtoul(red_rep2->element[6]->str, NULL, 10);
+            orders[loaded++] = order;
 
-        // Cleanup
-        freeReplyObject(red_rep1);
+            freeReplyObject(red_rep2);
+        }
+    }
 
-        // Return sequenced orders
-        return head;
+    // Sequence orders and link them in the list
+    qsort(orders, loaded, sizeof(order_t *), compare_orders_priority);
+    for (uint64_t i = 0; i + 1 < loaded; i++)
+    {
+        orders[i]->next = orders[i + 1];
     }
+    order_t *head = loaded > 0 ? orders[0] : NULL;
+
+    // Cleanup
+    free(orders);
+    freeReplyObject(red_rep1);
+
+    // Return sequenced orders
+    return head;
 }
 
-cid_ip_t *deserialize_cid_ip_redis(redisContext *red_con, char *redis_list)
+uint64_t deserialize_customers_redis(redisContext *red_con, char *redis_list, customer_directory_t *cd)
 {
-    /*  Helper function to read customer to IP mapping from Redis */
+    /*  Helper function to read customer to IP mapping from Redis into the directory.
+        Returns the number of customers in the directory. */
+    redisReply *red_rep = redisCommand(red_con, "HGETALL %s", redis_list);
+    if (red_rep == NULL || red_rep->type != REDIS_REPLY_ARRAY)
+    {
+        freeReplyObject(red_rep);
+        return cd->customers;
+    }
 
-    // Get list of open orders
-    redisReply *red_rep1 = redisCommand(red_con, "HGETALL %s", redis_list);
+    // Loop through all pairs of customer ID and IP returned by Redis
+    for (uint64_t i = 0; i + 1 < red_rep->elements; i += 2)
+    {
+        uint64_t customer_id = intern_customer(cd, red_rep->element[i]->str);
+        if (customer_id == MAX_CUSTOMERS)
+        {
+            break;
+        }
+        strncpy(cd->ips[customer_id], red_rep->element[i + 1]->str, INET_ADDRSTRLEN - 1);
+    }
 
-    // Set pointer to null and free it if there are no orders
-    if (red_rep1->elements == 0)
+    // Cleanup
+    freeReplyObject(red_rep);
+
+    return cd->customers;
+}
+
+uint64_t deserialize_last_oid_redis(redisContext *red_con, char *redis_key)
+{
+    /*  Helper function to read the highest order id, which was ever persisted in Redis.
+        Returns `0` if it is not set. */
+    redisReply *red_rep = redisCommand(red_con, "GET %s", redis_key);
+    uint64_t oid = 0;
+    if (red_rep != NULL && red_rep->type == REDIS_REPLY_STRING)
     {
-        freeReplyObject(red_rep1);
-        return NULL;
+        oid = strtoull(red_rep->str, NULL, 10);
     }
 
-    // Build mapping
-    cid_ip_t *head = malloc(sizeof(cid_ip_t));
-    if (head == NULL)
+    // Cleanup
+    freeReplyObject(red_rep);
+
+    return oid;
+}
+
+uint64_t deserialize_execution_redis(redisReply *entry, exec_notification_t *notification)
+{
+    /*  Helper function to read the entry of the stream of executions, which is the pair of id and list of fields */
+    memset(notification, 0, sizeof(exec_notification_t));
+    if (entry->type != REDIS_REPLY_ARRAY || entry->elements != 2 || entry->element[0]->type != REDIS_REPLY_STRING)
     {
-        printf("ERROR: Cannot allocate memory\n");
-        free(head);
-        exit(1);
+        return 1;
+    }
+    strncpy(notification->stream_id, entry->element[0]->str, REDIS_STREAM_ID_LEN - 1);
+    if (entry->element[1]->type != REDIS_REPLY_ARRAY)
+    {
+        return 1;
     }
 
-    cid_ip_t *tail = head;
-    // Loop through all entries returned by Redis
-    for (uint64_t i = 0; i < red_rep1->elements; i += 2)
+    // Set fields by their names
+    redisReply *fields = entry->element[1];
+    uint64_t found = 0;
+    for (uint64_t i = 0; i + 1 < fields->elements; i += 2)
     {
-        // Get customer ID
-        tail->cid = calloc(37, sizeof(char));
-        memcpy(tail->cid, red_rep1->element[i]->str, 36);
+        char *name = fields->element[i]->str;
+        char *value = fields->element[i + 1]->str;
+        if (strcmp(name, "oid") == 0)
+        {
+            notification->oid = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "cid") == 0)
+        {
+            strncpy(notification->cid, value, 36);
+        }
+        else if (strcmp(name, "t_server") == 0)
+        {
+            notification->t_server = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "t_exec") == 0)
+        {
+            notification->t_exec = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "qty") == 0)
+        {
+            notification->quantity = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "leaves") == 0)
+        {
+            notification->leaves = strtoul(value, NULL, 10);
+        }
+        else
+        {
+            continue;
+        }
+        found++;
+    }
 
-        // Get IP
-        tail->ip = calloc(16, sizeof(char));
-        memcpy(tail->ip, red_rep1->element[i + 1]->str, 15);
+    // All fields must be present
+    return found == 6 ? 0 : 2;
+}
 
-        // Allocate memory for new node only if this is not the last element
-        if (i != red_rep1->elements - 2)
-        {
-            // Create new end node
-            cid_ip_t *new_mapping = malloc(sizeof(cid_ip_t));
+uint64_t deserialize_book_event_redis(redisReply *entry, book_event_t *event)
+{
+    /*  Helper function to read the entry of the stream of book events, which is the pair of id and list of fields */
+    memset(event, 0, sizeof(book_event_t));
+    if (entry->type != REDIS_REPLY_ARRAY || entry->elements != 2 || entry->element[1]->type != REDIS_REPLY_ARRAY)
+    {
+        return 1;
+    }
 
-            //  Update tail to point to new order
-            tail->next = new_mapping;
-            tail = tail->next;
+    // Set fields by their names
+    redisReply *fields = entry->element[1];
+    uint64_t found = 0;
+    for (uint64_t i = 0; i + 1 < fields->elements; i += 2)
+    {
+        char *name = fields->element[i]->str;
+        char *value = fields->element[i + 1]->str;
+        if (strcmp(name, "type") == 0)
+        {
+            event->type = value[0];
+        }
+        else if (strcmp(name, "oid") == 0)
+        {
+            event->oid = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "symbol") == 0)
+        {
+            strncpy(event->symbol, value, SYMBOL_LEN);
+        }
+        else if (strcmp(name, "op") == 0)
+        {
+            event->operation = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "price") == 0)
+        {
+            event->price = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "qty") == 0)
+        {
+            event->quantity = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "leaves") == 0)
+        {
+            event->leaves = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(name, "t") == 0)
+        {
+            event->t_server = strtoul(value, NULL, 10);
+        }
+        // Match id is optional, entries written before it was added are read with zero match id
+        else if (strcmp(name, "match") == 0)
+        {
+            event->match_id = strtoul(value, NULL, 10);
+            continue;
         }
-        // Explicitly null next at the end of the linked list
         else
         {
-            tail->next = NULL;
+            continue;
         }
+        found++;
     }
 
-    // Cleanup
-    freeReplyObject(red_rep1);
-
-    // Return orders
-    return head;
+    // All required fields must be present
+    return found == MD_EVENT_FIELDS ? 0 : 2;
 }
\ No newline at end of file
@@ -6,6 +6,10 @@
 #include "types.h"
 
 // Declare function prototypes
-order_t *deserialize_order_wire(char *message, uint64_t oid);
+order_t *deserialize_order_wire(char *message, uint64_t oid, pool_t *pool);
+order_t *deserialize_order_binary(char *message, uint64_t length, char *cid, uint64_t oid, pool_t *pool);
 order_t *deserialize_order_redis(redisContext *red_con, char *redis_list);
-cid_ip_t *deserialize_cid_ip_redis(redisContext *red_con, char *redis_list);
\ No newline at end of file
+uint64_t deserialize_customers_redis(redisContext *red_con, char *redis_list, customer_directory_t *cd);
+uint64_t deserialize_last_oid_redis(redisContext *red_con, char *redis_key);
+uint64_t deserialize_execution_redis(redisReply *entry, exec_notification_t *notification);
+uint64_t deserialize_book_event_redis(redisReply *entry, book_event_t *event);
\ No newline at end of file
@@ -0,0 +1,101 @@
+/* This file contains the bounded single-producer/single-consumer ring buffer. Elements of fixed size are copied
+   in and out of the ring, producer and consumer only share two counters, each of them on its own cache line. */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+
+// Local headers
+#include "spsc_ring.h"
+#include "log.h"
+
+// Define aux functions
+uint64_t init_spsc_ring(spsc_ring_t *ring, uint64_t capacity, uint64_t element_size)
+{
+    /* Helper function to initialize empty ring, capacity must be power of two */
+    ring->capacity = capacity;
+    ring->element_size = element_size;
+    ring->buffer = calloc(capacity, element_size);
+    if (ring->buffer == NULL)
+    {
+        LOG_ERROR("Unable to allocate memory for ring buffer");
+        return 1;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->cached_head = 0;
+    ring->cached_tail = 0;
+    atomic_init(&ring->full_count, 0);
+    atomic_init(&ring->high_watermark, 0);
+
+    // Success
+    return 0;
+}
+
+bool spsc_ring_push(spsc_ring_t *ring, void *element)
+{
+    /* Helper function to add the element to the ring, it is called only by the producer.
+       Returns `false` if the ring is full, the caller decides whether to wait or to drop it. */
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    // Consumer position is read from the shared counter only when the cached one says the ring is full
+    if (tail - ring->cached_head == ring->capacity)
+    {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->cached_head == ring->capacity)
+        {
+            return false;
+        }
+    }
+
+    memcpy(ring->buffer + (tail & (ring->capacity - 1)) * ring->element_size, element, ring->element_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    // Keep the deepest seen queue for back-pressure metrics
+    uint64_t depth = tail + 1 - ring->cached_head;
+    if (depth > atomic_load_explicit(&ring->high_watermark, memory_order_relaxed))
+    {
+        atomic_store_explicit(&ring->high_watermark, depth, memory_order_relaxed);
+    }
+
+    return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t *ring, void *element)
+{
+    /* Helper function to take the oldest element from the ring, it is called only by the consumer.
+       Returns `false` if the ring is empty. */
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // Producer position is read from the shared counter only when the cached one says the ring is empty
+    if (head == ring->cached_tail)
+    {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->cached_tail)
+        {
+            return false;
+        }
+    }
+
+    memcpy(element, ring->buffer + (head & (ring->capacity - 1)) * ring->element_size, ring->element_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+uint64_t spsc_ring_depth(spsc_ring_t *ring)
+{
+    /* Helper function to get the number of elements in the ring, it is approximate if called concurrently */
+    return atomic_load_explicit(&ring->tail, memory_order_acquire) - atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+void free_spsc_ring(spsc_ring_t *ring)
+{
+    /* Helper function to clean up the memory used by the ring */
+    free(ring->buffer);
+    ring->buffer = NULL;
+}
\ No newline at end of file
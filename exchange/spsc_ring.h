@@ -0,0 +1,16 @@
+/* This file contains header for the bounded single-producer/single-consumer ring buffer used to pass
+   events between threads without locks */
+
+// Preprocessor directives
+#include <stdint.h>
+#include <stdbool.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t init_spsc_ring(spsc_ring_t *ring, uint64_t capacity, uint64_t element_size);
+bool spsc_ring_push(spsc_ring_t *ring, void *element);
+bool spsc_ring_pop(spsc_ring_t *ring, void *element);
+uint64_t spsc_ring_depth(spsc_ring_t *ring);
+void free_spsc_ring(spsc_ring_t *ring);
\ No newline at end of file
@@ -0,0 +1,92 @@
+/* This file contains the directory of traded symbols: open-addressing hash table, which interns
+   symbols into dense ids used to index the order books */
+
+// Preprocessor directives
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+// Local headers
+#include "symbol_directory.h"
+
+// Define aux functions
+uint64_t hash_symbol(char *symbol)
+{
+    /* Helper function to calculate FNV-1a hash of the symbol */
+    uint64_t hash = 14695981039346656037UL;
+    for (uint64_t i = 0; i < SYMBOL_LEN && symbol[i] != '\0'; i++)
+    {
+        hash ^= (unsigned char)symbol[i];
+        hash *= 1099511628211UL;
+    }
+
+    return hash;
+}
+
+uint64_t intern_symbol(symbol_directory_t *sd, char *symbol)
+{
+    /* Helper function to get id of the symbol, adding the symbol to directory if it is new.
+       Symbol is normalized to upper case in place. Returns MAX_SYMBOLS if the symbol is empty or the directory is full. */
+
+    // Empty symbol can't be told from the free slot, so it would get the new id every time
+    if (symbol[0] == '\0')
+    {
+        return MAX_SYMBOLS;
+    }
+
+    // Normalize chars to upper case
+    for (uint64_t i = 0; i < SYMBOL_LEN && symbol[i] != '\0'; i++)
+    {
+        symbol[i] = toupper(symbol[i]);
+    }
+
+    // Probe the table starting from the hashed slot
+    uint64_t slot = hash_symbol(symbol) & (SYMBOL_DIRECTORY_SIZE - 1);
+    while (sd->slots[slot].symbol[0] != '\0')
+    {
+        if (strncmp(sd->slots[slot].symbol, symbol, SYMBOL_LEN) == 0)
+        {
+            return sd->slots[slot].symbol_id;
+        }
+        slot = (slot + 1) & (SYMBOL_DIRECTORY_SIZE - 1);
+    }
+
+    // Add new symbol to the free slot
+    if (sd->symbols == MAX_SYMBOLS)
+    {
+        printf("%lu: Symbol directory is full, unable to add '%s'\n", time(NULL), symbol);
+        return MAX_SYMBOLS;
+    }
+
+    strncpy(sd->slots[slot].symbol, symbol, SYMBOL_LEN);
+    sd->slots[slot].symbol_id = sd->symbols;
+    strncpy(sd->names[sd->symbols], symbol, SYMBOL_LEN);
+
+    return sd->symbols++;
+}
+
+uint64_t load_symbols(symbol_directory_t *sd, char *filename)
+{
+    /* Helper function to intern the symbol universe from file with one symbol per line.
+       Returns the number of symbols in the directory. */
+    FILE *fptr = fopen(filename, "r");
+    if (fptr == NULL)
+    {
+        perror("Error: Cannot open symbols file: ");
+        return sd->symbols;
+    }
+
+    char symbol[SYMBOL_LEN + 1];
+    memset(symbol, '\0', sizeof(symbol));
+    while (fscanf(fptr, "%10s", symbol) == 1)
+    {
+        intern_symbol(sd, symbol);
+        memset(symbol, '\0', sizeof(symbol));
+    }
+
+    fclose(fptr);
+
+    return sd->symbols;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+/* This file contains header for the directory of traded symbols, which maps symbols to dense ids */
+
+// Preprocessor directives
+#include <stdint.h>
+
+// Local headers
+#include "types.h"
+
+// Declare function prototypes
+uint64_t hash_symbol(char *symbol);
+uint64_t intern_symbol(symbol_directory_t *sd, char *symbol);
+uint64_t load_symbols(symbol_directory_t *sd, char *filename);
\ No newline at end of file
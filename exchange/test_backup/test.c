@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <time.h>
 #include <hiredis/hiredis.h>
 
@@ -10,6 +11,8 @@
 #include "helper.h"
 #include "comm.h"
 #include "matching_engine.h"
+#include "symbol_directory.h"
+#include "pool.h"
 #include "serializers.h"
 
 // Main function
@@ -21,8 +24,8 @@ int main(void)
     // Initialize matching engine
     uint64_t orders = 0; // Later this will be reading existing order queue from Redis
 
-    // Initialize trading trie
-    trading_trie_t *tt = add_node_to_trie('\0');
+    // Initialize matching engine
+    matching_engine_t *me = create_matching_engine();
 
     // Open connection to Redis
     redisContext *red_con = redisConnect(addr_redis->ip, addr_redis->port);
@@ -43,7 +46,7 @@ int main(void)
         // Create temp pointer to be able to NULL the next field
         order_t *temp_order = head;
 
-        // Page head and NULL next in temp_order, which is added to trie
+        // Page head and NULL next in temp_order, which is added to order book
         head = head->next;
         temp_order->next = NULL;
 
@@ -57,20 +60,26 @@ int main(void)
         //        temp_order->price,
         //        temp_order->quantity);
 
-        // Load item to the trading trie with flag init=true to avoid re-loading orders to Redis
-        match_trade(tt, temp_order, red_con, true);
-
-        // Set orders num to the vaule of the last existing
-        if (head == NULL)
+        // Set orders num to the biggest existing id, orders are sequenced by price, not by id
+        if (temp_order->oid > orders)
         {
             orders = temp_order->oid;
         }
+
+        // Move order to the pool of the matching engine
+        order_t *pooled_order = pool_alloc(&me->orders);
+        memcpy(pooled_order, temp_order, sizeof(order_t));
+        free(temp_order);
+
+        // Load item to the order book with flag init=true to avoid re-loading orders to Redis
+        pooled_order->symbol_id = intern_symbol(&me->symbols, pooled_order->symbol);
+        match_trade(me, pooled_order, true);
     }
 
     printf("Last order id: %lu\n", orders);
 
     // Cleanup
-    free_trie(tt);
+    free_matching_engine(me);
     redisFree(red_con);
     free(addr_redis);
 
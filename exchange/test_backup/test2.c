@@ -12,7 +12,9 @@
 #include "helper.h"
 #include "comm.h"
 #include "matching_engine.h"
+#include "symbol_directory.h"
 #include "serializers.h"
+#include "persistence.h"
 
 // Main function
 int main(void)
@@ -23,8 +25,8 @@ int main(void)
     // Initialize matching engine
     uint64_t orders = 0; // Later this will be reading existing order queue from Redis
 
-    // Initialize trading trie
-    trading_trie_t *tt = add_node_to_trie('\0');
+    // Initialize matching engine
+    matching_engine_t *me = create_matching_engine();
 
     // Load orders
     FILE *fptr = fopen("test_input.txt", "r");
@@ -43,14 +45,22 @@ int main(void)
     }
     printf("%lu: Connected to Redis\n", time(NULL));
 
+    // Write state changes to Redis from the persistence thread
+    persistence_t persistence;
+    if (start_persistence(&persistence, red_con) != 0)
+    {
+        return 21;
+    }
+    me->persistence = &persistence.ring;
+
     // Simulate read from wire
     char *buf = calloc(MAX_MSG_LEN, sizeof(char));
     while (fscanf(fptr, "%s", buf) != EOF)
     {
         orders++;
 
-        order_t *order = deserialize_order_wire(buf, orders);
-        printf("ORDER:\n  cid: %s\n  oid: %lu\n  t_client: %lu\n  t_server: %lu\n  symbol: %s\n  op: %lu\n  price: %.2f\n  qty: %lu\n",
+        order_t *order = deserialize_order_wire(buf, orders, &me->orders);
+        printf("ORDER:\n  cid: %s\n  oid: %lu\n  t_client: %lu\n  t_server: %lu\n  symbol: %s\n  op: %lu\n  price: %lu\n  qty: %lu\n",
                order->cid,
                order->oid,
                order->t_client,
@@ -60,8 +70,9 @@ int main(void)
                order->price,
                order->quantity);
 
-        // Test trading trie
-        match_trade(tt, order, red_con, false);
+        // Test matching engine
+        order->symbol_id = intern_symbol(&me->symbols, order->symbol);
+        match_trade(me, order, false);
 
         // Reallocate buffer
         free(buf);
@@ -69,8 +80,9 @@ int main(void)
     }
     free(buf);
 
-    // Cleanup
-    free_trie(tt);
+    // Cleanup, stopping the persistence thread drains the remaining events
+    stop_persistence(&persistence);
+    free_matching_engine(me);
     fclose(fptr);
     redisFree(red_con);
 
@@ -0,0 +1,58 @@
+/* Test with interning empty keys in the symbol and customer directories, they must not use up the ids */
+
+// Preprocessing
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Local code
+#include "symbol_directory.h"
+#include "customer_directory.h"
+
+// Main function
+int main(void)
+{
+    static symbol_directory_t symbols;
+    static customer_directory_t customers;
+    uint64_t failures = 0;
+
+    // More empty keys than the directories can hold
+    for (uint64_t i = 0; i < MAX_CUSTOMERS + 1; i++)
+    {
+        char symbol[SYMBOL_LEN + 1] = "";
+        char cid[37] = "";
+        if (intern_symbol(&symbols, symbol) != MAX_SYMBOLS || intern_customer(&customers, cid) != MAX_CUSTOMERS)
+        {
+            failures++;
+        }
+    }
+    printf("Empty keys: %lu accepted, %lu symbols and %lu customers interned\n", failures, symbols.symbols, customers.customers);
+    if (symbols.symbols != 0 || customers.customers != 0)
+    {
+        failures++;
+    }
+
+    // New keys still get new ids, the known ones keep their ids
+    char symbol[SYMBOL_LEN + 1] = "aapl";
+    char symbol_upper[SYMBOL_LEN + 1] = "AAPL";
+    char cid[37] = "customer";
+    if (intern_symbol(&symbols, symbol) != 0 || intern_symbol(&symbols, symbol_upper) != 0 ||
+        intern_customer(&customers, cid) != 0 || intern_customer(&customers, cid) != 0 ||
+        find_customer(&customers, "") != MAX_CUSTOMERS)
+    {
+        printf("New keys are not interned\n");
+        failures++;
+    }
+
+    if (failures > 0)
+    {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("PASSED\n");
+
+    // Success
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+/* Test with the order, which partially crosses the book, its executions must be persisted before its remainder */
+
+// Preprocessing
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Local code
+#include "matching_engine.h"
+#include "spsc_ring.h"
+#include "symbol_directory.h"
+#include "pool.h"
+
+// Define aux functions
+static void add_order(matching_engine_t *me, uint64_t oid, uint64_t operation, uint64_t price, uint64_t quantity)
+{
+    /* Helper function to match the new order of the test symbol */
+    order_t *order = pool_alloc(&me->orders);
+    memset(order, 0, sizeof(order_t));
+    order->oid = oid;
+    order->t_server = oid;
+    order->operation = operation;
+    order->price = price;
+    order->quantity = quantity;
+    strcpy(order->cid, "test");
+    strcpy(order->symbol, "TEST");
+    order->symbol_id = intern_symbol(&me->symbols, order->symbol);
+    match_trade(me, order, false);
+}
+
+static uint64_t check_events(spsc_ring_t *ring, char *name, uint64_t *types, uint64_t *oids, uint64_t count)
+{
+    /* Helper function to compare the persisted events with the expected sequence, the oid of the execution
+       is the oid of its resting order */
+    persistence_event_t event;
+    uint64_t i = 0;
+    bool is_matching = true;
+    while (spsc_ring_pop(ring, &event))
+    {
+        uint64_t oid = event.type == PERSIST_EXECUTION ? event.execution.resting_oid : event.order.oid;
+        if (i >= count || event.type != types[i] || oid != oids[i])
+        {
+            is_matching = false;
+        }
+        i++;
+    }
+    printf("%s: %lu events, %s\n", name, i, is_matching && i == count ? "in sequence" : "out of sequence");
+
+    return is_matching && i == count ? 0 : 1;
+}
+
+// Main function
+int main(void)
+{
+    static spsc_ring_t ring;
+    matching_engine_t *me = create_matching_engine();
+    if (me == NULL || init_spsc_ring(&ring, 64, sizeof(persistence_event_t)) != 0)
+    {
+        return 1;
+    }
+    me->persistence = &ring;
+    uint64_t failures = 0;
+
+    // Buy crosses both resting sells and rests with the remainder
+    add_order(me, 1, 0, 100, 10);
+    add_order(me, 2, 0, 100, 20);
+    add_order(me, 3, 1, 100, 50);
+    uint64_t partial_types[] = {PERSIST_ORDER, PERSIST_ORDER, PERSIST_EXECUTION, PERSIST_EXECUTION, PERSIST_ORDER};
+    uint64_t partial_oids[] = {1, 2, 1, 2, 3};
+    failures += check_events(&ring, "Partial cross", partial_types, partial_oids, 5);
+
+    // Sell fills the remainder completely, its details follow the execution
+    add_order(me, 4, 0, 100, 20);
+    uint64_t full_types[] = {PERSIST_EXECUTION, PERSIST_ORDER_DETAILS};
+    uint64_t full_oids[] = {3, 4};
+    failures += check_events(&ring, "Full cross", full_types, full_oids, 2);
+
+    // Replacement at the crossing price cancels the resting order first, then its executions precede its remainder
+    add_order(me, 5, 1, 90, 10);
+    add_order(me, 6, 0, 110, 30);
+    order_t *replacement = pool_alloc(&me->orders);
+    memset(replacement, 0, sizeof(order_t));
+    replacement->oid = 7;
+    replacement->t_server = 7;
+    replacement->operation = 3;
+    replacement->price = 90;
+    replacement->quantity = 30;
+    replacement->target_oid = 6;
+    strcpy(replacement->cid, "test");
+    match_trade(me, replacement, false);
+    uint64_t replace_types[] = {PERSIST_ORDER, PERSIST_ORDER, PERSIST_CANCEL, PERSIST_EXECUTION, PERSIST_ORDER};
+    uint64_t replace_oids[] = {5, 6, 6, 5, 7};
+    failures += check_events(&ring, "Replacement cross", replace_types, replace_oids, 5);
+
+    // Cleanup
+    free_matching_engine(me);
+    free_spsc_ring(&ring);
+
+    if (failures > 0)
+    {
+        printf("FAILED\n");
+        return 2;
+    }
+    printf("PASSED\n");
+
+    // Success
+    return 0;
+}
\ No newline at end of file
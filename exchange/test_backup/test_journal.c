@@ -0,0 +1,118 @@
+/* Test with appending orders to the journal while the snapshot is written, the reload has to keep all of them */
+
+// Preprocessing
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+// Local code
+#include "matching_engine.h"
+#include "journal.h"
+#include "order_index.h"
+#include "symbol_directory.h"
+#include "pool.h"
+
+// Orders before the fork make the snapshot slow enough, so the parent appends while the child writes it
+#define TEST_ORDERS_BEFORE_SNAPSHOT 200000
+#define TEST_ORDERS_AFTER_SNAPSHOT 1000
+
+// Define aux functions
+static uint64_t add_orders(matching_engine_t *me, uint64_t first_oid, uint64_t count)
+{
+    /* Helper function to journal and to match the buy orders, which never cross, so all of them rest in the book */
+    for (uint64_t oid = first_oid; oid < first_oid + count; oid++)
+    {
+        order_t *order = pool_alloc(&me->orders);
+        if (order == NULL)
+        {
+            return 1;
+        }
+        memset(order, 0, sizeof(order_t));
+        order->oid = oid;
+        order->t_server = oid;
+        order->operation = 1;
+        order->price = 100 + oid % 50;
+        order->quantity = 1;
+        strcpy(order->cid, "test");
+        strcpy(order->symbol, "TEST");
+        order->symbol_id = intern_symbol(&me->symbols, order->symbol);
+        match_trade(me, order, false);
+    }
+
+    // Success
+    return 0;
+}
+
+// Main function
+int main(void)
+{
+    char path[] = "/tmp/test_journal.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        perror("Error: Cannot create journal: ");
+        return 1;
+    }
+    close(fd);
+    unlink(path);
+
+    // Journal orders, take the snapshot and keep journaling while it is written
+    static journal_t journal;
+    matching_engine_t *me = create_matching_engine();
+    if (me == NULL || open_journal(&journal, path) != 0)
+    {
+        return 2;
+    }
+    me->journal = &journal;
+    uint64_t total = TEST_ORDERS_BEFORE_SNAPSHOT + TEST_ORDERS_AFTER_SNAPSHOT;
+    if (add_orders(me, 1, TEST_ORDERS_BEFORE_SNAPSHOT) != 0 ||
+        take_snapshot(&journal, me) != 0 ||
+        add_orders(me, TEST_ORDERS_BEFORE_SNAPSHOT + 1, TEST_ORDERS_AFTER_SNAPSHOT) != 0)
+    {
+        return 3;
+    }
+    close_journal(&journal);
+    free_matching_engine(me);
+
+    // Reload from the snapshot and the tail of the journal, as the exchange does at startup
+    me = create_matching_engine();
+    uint64_t last_oid = 0;
+    if (me == NULL || open_journal(&journal, path) != 0 ||
+        load_snapshot(&journal, me, &last_oid) != 0 || replay_journal(&journal, me, &last_oid) != 0)
+    {
+        return 4;
+    }
+
+    uint64_t missing = 0;
+    for (uint64_t oid = 1; oid <= total; oid++)
+    {
+        if (find_order_in_index(&me->index, oid) == NULL)
+        {
+            missing++;
+        }
+    }
+    printf("Snapshot at journaled order %lu, last order %lu, %lu of %lu orders are missing\n",
+           journal.snapshot_length,
+           last_oid,
+           missing,
+           total);
+
+    // Cleanup
+    close_journal(&journal);
+    free_matching_engine(me);
+    unlink(path);
+    unlink(journal.snapshot_path);
+
+    if (missing > 0 || last_oid != total)
+    {
+        printf("FAILED\n");
+        return 5;
+    }
+    printf("PASSED\n");
+
+    // Success
+    return 0;
+}
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 // Preprocessor directives
 #include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include <arpa/inet.h>
 
 // Statics
@@ -11,19 +14,157 @@
 #define EXCHANGE_MCAST_PROTOCOL IPPROTO_UDP
 #define CUSTOMER_PROTOCOL IPPROTO_TCP
 
+// Order sessions data, each order is framed with 2 bytes length in network byte order
+#define ORDER_FRAME_HEADER_LEN 2
+#define ORDER_SESSION_BUFFER_LEN 16384
+#define ORDER_WIRE_FIELDS 6
+
+// Binary order entry message types
+#define ORDER_ENTRY_LOGON 'L'
+#define ORDER_ENTRY_ORDER 'O'
+#define ORDER_ENTRY_CANCEL 'X'
+#define ORDER_ENTRY_REPLACE 'U'
+#define ORDER_ENTRY_ACK 'A'
+
+// Order gateway event loop data, read budget is number of reads per session before others are served
+#define ORDER_MAX_EVENTS 256
+#define ORDER_SESSION_READ_BUDGET 4
+#define ORDER_SESSION_MAX_WRITE_QUEUE 1048576
+
 // Redis data
 #define REDIS_EXCHANGE_A_ORDERS "active_orders"
-#define REDIS_EXCHANGE_E_ORDERS "executed_orders"
+#define REDIS_EXCHANGE_EXEC_STREAM "executions"
+#define REDIS_EXCHANGE_EXEC_GROUP "exec"
+#define REDIS_EXCHANGE_EXEC_CONSUMER "exec-1"
+#define REDIS_EXEC_STREAM_MAXLEN 1000000
+#define REDIS_EXEC_READ_COUNT 512
+#define REDIS_EXCHANGE_BOOK_STREAM "book_events"
+#define REDIS_BOOK_STREAM_MAXLEN 1000000
+#define REDIS_BOOK_READ_COUNT 512
 #define REDIS_EXCHANGE_C2IP "c2ip"
 #define REDIS_EXCHANGE_ORDER_PREFIX "order"
+#define REDIS_EXCHANGE_LAST_OID "last_oid"
+#define REDIS_PIPELINE_DEPTH 4096
+#define REDIS_STREAM_ID_LEN 48
+
+// Execution notifier data, each customer has one persistent connection with many notifications in flight,
+// failed connections are retried after the interval in milliseconds
+#define EXEC_RING_SIZE 65536
+#define EXEC_MAX_EVENTS 64
+#define EXEC_MAX_IN_FLIGHT 65536
+#define EXEC_RECONNECT_INTERVAL 1000
+#define EXEC_BUFFER_LEN 4096
+
+// Market data events, book changes are published in the stream and sent by market_data as deltas
+#define MD_EVENT_ADD 'A'
+#define MD_EVENT_EXECUTE 'E'
+#define MD_EVENT_CANCEL 'X'
+#define MD_EVENT_FIELDS 8
+
+// Market data protocol, ITCH-style binary messages are packed into MoldUDP64-style datagrams, which fit into the MTU.
+// Datagrams are sent in batches and the partial one waits for more messages not longer than the delay in microseconds.
+#define MD_EVENT_SYSTEM 'S'
+#define MD_SYSTEM_START 'O'
+#define MD_SYSTEM_END 'C'
+#define MD_SIDE_BUY 'B'
+#define MD_SIDE_SELL 'S'
+#define MD_SESSION_LEN 10
+#define MD_MAX_PAYLOAD 1472
+#define MD_MAX_PACKETS 64
+#define MD_MAX_DELAY_US 100
+
+// Market data retransmission, the last messages are kept in the ring and are sent again over TCP on request,
+// the size of the ring is power of two and the request is served within the timeout in seconds
+#define MD_MAX_MESSAGE_LEN 64
+#define MD_RETRANSMIT_RING_SIZE 65536
+#define MD_MAX_RETRANSMIT 1024
+#define MD_REWIND_TIMEOUT 1
+
+// Market data snapshots, market_data keeps its own copy of the books and sends the book of the next symbol
+// on the snapshot channel every interval in microseconds
+#define MD_EVENT_SNAPSHOT 'G'
+#define MD_SNAPSHOT_INTERVAL_US 1000
+
+// Market data channels, symbols are sharded across the channels by the hash of the symbol. Each channel has its own
+// multicast groups and sequence numbers, the directory tells clients the channel of each symbol they are interested in.
+#define MD_CHANNELS 1
+#define MD_MAX_CHANNELS 16
+#define MD_MAX_DIRECTORY_SYMBOLS 1024
+
+// Market data quotes, best bid and offer of the symbols, which changed, are sent on the QBBO channel once every interval
+// in microseconds, so only the latest quote of the symbol is sent
+#define MD_EVENT_QUOTE 'Q'
+#define MD_QBBO_INTERVAL_US 1000
+
+// Market data trades, every fill is reported on the Last Sale channel, which is batched and retransmitted as deltas
+#define MD_EVENT_TRADE 'P'
 
-// Trie data
-#define N 26
+// Persistence data, events are passed from the matching thread to the persistence thread through the ring
+#define PERSISTENCE_RING_SIZE 65536
+#define PERSISTENCE_STATS_INTERVAL 10
+#define PERSIST_ORDER 1
+#define PERSIST_ORDER_DETAILS 2
+#define PERSIST_CANCEL 3
+#define PERSIST_EXECUTION 4
+#define PERSIST_CUSTOMER 5
+
+// Journal data, the file is grown and re-mapped by chunks, the snapshot of books is taken every interval of orders
+#define JOURNAL_MAGIC "EXJRNL01"
+#define JOURNAL_CHUNK_SIZE 67108864
+#define JOURNAL_PATH_LEN 4096
+#define JOURNAL_SNAPSHOT_MAGIC "EXSNAP01"
+#define JOURNAL_SNAPSHOT_INTERVAL 1000000
+#define JOURNAL_SNAPSHOT_BATCH 512
+
+// Price data, prices are kept as integer number of ticks
+#define PRICE_SCALE 100
+
+// Pool data, number of objects allocated at once per slab
+#define POOL_ORDERS_SLAB 4096
+#define POOL_EXECUTIONS_SLAB 256
+#define POOL_LEVELS_SLAB 1024
+
+// Symbol directory data, the size of the hash table is power of two and at least twice bigger than number of symbols
+#define SYMBOL_LEN 10
+#define MAX_SYMBOLS 8192
+#define SYMBOL_DIRECTORY_SIZE 16384
+
+// Customer directory data, the size of the hash table is power of two and at least twice bigger than number of customers
+#define MAX_CUSTOMERS 16384
+#define CUSTOMER_DIRECTORY_SIZE 32768
+
+// Order book data
+#define BOOK_INITIAL_DEPTH 16
+
+// Match data, match id is the id of the aggressor order followed by the number of the fill, so it is unique
+// without any state, which would have to survive the restart
+#define MATCH_FILL_BITS 20
+
+// Order index data, the size of the hash table is power of two
+#define ORDER_INDEX_INITIAL_CAPACITY 65536
 
 // Custom data types
 #ifndef _MY_HEADER_H_
 #define _MY_HEADER_H_
 
+typedef uint64_t price_t;
+
+typedef struct pool_slab_t
+{
+    struct pool_slab_t *next;
+    unsigned char objects[];
+} pool_slab_t;
+
+typedef struct pool_t
+{
+    uint64_t object_size;
+    uint64_t slab_objects;
+    uint64_t capacity;
+    uint64_t used;
+    void *free_list;
+    struct pool_slab_t *slabs;
+} pool_t;
+
 typedef struct order_t
 {
     char cid[37];
@@ -31,30 +172,221 @@ typedef struct order_t
     uint64_t t_client;
     uint64_t t_server;
     char symbol[11];
+    uint64_t symbol_id;
     uint64_t operation;
-    float price;
+    price_t price;
     uint64_t quantity;
+    uint64_t target_oid;
+    struct price_level_t *level;
     struct order_t *next;
     struct order_t *previous;
 } order_t;
 
-typedef struct trading_trie_t
+typedef struct execution_t
 {
-    char symbol;
-    struct trading_trie_t *next[N];
-    struct order_t *sell_head;
-    struct order_t *sell_tail;
-    struct order_t *buy_head;
-    struct order_t *buy_tail;
+    char symbol[11];
+    uint64_t t_server;
+    uint64_t operation;
+    price_t price;
+    uint64_t quantity;
+    uint64_t match_id;
+    uint64_t aggressor_oid;
+    uint64_t aggressor_leaves;
+    uint64_t aggressor_t_server;
+    char aggressor_cid[37];
+    uint64_t resting_oid;
+    uint64_t resting_leaves;
+    uint64_t resting_t_server;
+    char resting_cid[37];
+    struct execution_t *next;
+} execution_t;
 
-} trading_trie_t;
+typedef struct exec_notification_t
+{
+    char stream_id[REDIS_STREAM_ID_LEN];
+    uint64_t oid;
+    char cid[37];
+    uint64_t t_server;
+    uint64_t t_exec;
+    uint64_t quantity;
+    uint64_t leaves;
+} exec_notification_t;
 
-typedef struct cid_ip_t
+typedef struct in_flight_notification_t
 {
-    char *cid;
-    char *ip;
-    struct cid_ip_t *next;
-} cid_ip_t;
+    struct exec_notification_t notification;
+    uint64_t next;
+    bool is_acked;
+} in_flight_notification_t;
+
+typedef struct in_flight_entry_t
+{
+    uint64_t oid;
+    uint64_t first;
+    uint64_t last;
+} in_flight_entry_t;
+
+typedef struct price_level_t
+{
+    price_t price;
+    uint64_t quantity;
+    uint64_t orders;
+    struct order_t *head;
+    struct order_t *tail;
+} price_level_t;
+
+typedef struct book_side_t
+{
+    uint64_t operation;
+    uint64_t depth;
+    uint64_t capacity;
+    struct price_level_t **levels;
+    struct pool_t *levels_pool;
+} book_side_t;
+
+typedef struct order_book_t
+{
+    struct book_side_t sell;
+    struct book_side_t buy;
+} order_book_t;
+
+typedef struct symbol_entry_t
+{
+    char symbol[SYMBOL_LEN + 1];
+    uint64_t symbol_id;
+} symbol_entry_t;
+
+typedef struct symbol_directory_t
+{
+    uint64_t symbols;
+    struct symbol_entry_t slots[SYMBOL_DIRECTORY_SIZE];
+    char names[MAX_SYMBOLS][SYMBOL_LEN + 1];
+} symbol_directory_t;
+
+typedef struct book_event_t
+{
+    char type;
+    uint64_t oid;
+    char symbol[SYMBOL_LEN + 1];
+    uint64_t operation;
+    price_t price;
+    uint64_t quantity;
+    uint64_t leaves;
+    uint64_t t_server;
+    uint64_t match_id;
+} book_event_t;
+
+typedef struct md_retransmit_t
+{
+    int64_t sd;
+    pthread_t thread;
+    char session[MD_SESSION_LEN];
+    _Alignas(64) atomic_uint_fast64_t next_sequence;
+    uint16_t lengths[MD_RETRANSMIT_RING_SIZE];
+    char messages[MD_RETRANSMIT_RING_SIZE][MD_MAX_MESSAGE_LEN];
+} md_retransmit_t;
+
+typedef struct md_publisher_t
+{
+    int64_t sd;
+    struct sockaddr_in addr;
+    char session[MD_SESSION_LEN];
+    uint64_t sequence;
+    uint64_t max_delay;
+    uint64_t t_open;
+    uint64_t packets;
+    uint64_t lengths[MD_MAX_PACKETS];
+    uint16_t counts[MD_MAX_PACKETS];
+    char buffers[MD_MAX_PACKETS][MD_MAX_PAYLOAD];
+    struct md_retransmit_t *retransmit;
+} md_publisher_t;
+
+typedef struct md_directory_t
+{
+    int64_t sd;
+    pthread_t thread;
+    char session[MD_SESSION_LEN];
+    uint64_t channels;
+    struct sockaddr_in groups[MD_MAX_CHANNELS];
+    struct sockaddr_in snapshot_groups[MD_MAX_CHANNELS];
+    uint64_t rewind_ports[MD_MAX_CHANNELS];
+} md_directory_t;
+
+typedef struct customer_entry_t
+{
+    char cid[37];
+    uint64_t customer_id;
+} customer_entry_t;
+
+typedef struct customer_directory_t
+{
+    uint64_t customers;
+    struct customer_entry_t slots[CUSTOMER_DIRECTORY_SIZE];
+    char cids[MAX_CUSTOMERS][37];
+    char ips[MAX_CUSTOMERS][INET_ADDRSTRLEN];
+} customer_directory_t;
+
+typedef struct order_index_entry_t
+{
+    uint64_t oid;
+    struct order_t *order;
+} order_index_entry_t;
+
+typedef struct order_index_t
+{
+    uint64_t capacity;
+    uint64_t count;
+    struct order_index_entry_t *entries;
+} order_index_t;
+
+typedef struct md_quote_t
+{
+    price_t bid_price;
+    uint64_t bid_size;
+    price_t ask_price;
+    uint64_t ask_size;
+} md_quote_t;
+
+typedef struct md_book_t
+{
+    uint64_t next_symbol;
+    struct symbol_directory_t symbols;
+    struct order_index_t index;
+    struct pool_t orders;
+    struct pool_t levels;
+    struct order_book_t books[MAX_SYMBOLS];
+    uint64_t changed;
+    uint64_t changed_symbols[MAX_SYMBOLS];
+    bool is_changed[MAX_SYMBOLS];
+    struct md_quote_t quotes[MAX_SYMBOLS];
+} md_book_t;
+
+typedef struct spsc_ring_t
+{
+    uint64_t capacity;
+    uint64_t element_size;
+    unsigned char *buffer;
+    _Alignas(64) atomic_uint_fast64_t head;
+    uint64_t cached_tail;
+    _Alignas(64) atomic_uint_fast64_t tail;
+    uint64_t cached_head;
+    atomic_uint_fast64_t full_count;
+    atomic_uint_fast64_t high_watermark;
+} spsc_ring_t;
+
+typedef struct matching_engine_t
+{
+    struct symbol_directory_t symbols;
+    struct order_index_t index;
+    struct pool_t orders;
+    struct pool_t executions;
+    struct pool_t levels;
+    struct order_book_t books[MAX_SYMBOLS];
+    struct spsc_ring_t *persistence;
+    struct journal_t *journal;
+    struct md_publisher_t *last_sale;
+} matching_engine_t;
+
 
 typedef struct server_t
 {
@@ -63,6 +395,124 @@ typedef struct server_t
     uint64_t port;
 } server_t;
 
+typedef struct persistence_event_t
+{
+    uint64_t type;
+    union
+    {
+        struct order_t order;
+        struct execution_t execution;
+        struct
+        {
+            char cid[37];
+            char ip[INET_ADDRSTRLEN];
+        } customer;
+    };
+} persistence_event_t;
+
+typedef struct persistence_t
+{
+    struct spsc_ring_t ring;
+    struct redisContext *red_con;
+    pthread_t thread;
+    atomic_bool is_stopping;
+} persistence_t;
+
+typedef struct customer_connection_t
+{
+    int64_t sd;
+    char ip[INET_ADDRSTRLEN];
+    bool is_connected;
+    uint64_t t_retry;
+    struct in_flight_notification_t *in_flight;
+    struct in_flight_entry_t *in_flight_index;
+    uint64_t in_flight_head;
+    uint64_t in_flight_tail;
+    uint64_t in_flight_count;
+    uint64_t in_flight_capacity;
+    char *write_buffer;
+    uint64_t write_offset;
+    uint64_t write_length;
+    uint64_t write_capacity;
+    char read_buffer[EXEC_BUFFER_LEN];
+    uint64_t read_length;
+    struct customer_connection_t *next;
+} customer_connection_t;
+
+typedef struct notifier_t
+{
+    int64_t epfd;
+    int64_t event_fd;
+    struct spsc_ring_t ring;
+    pthread_t reader;
+    struct redisContext *red_con;
+    struct redisContext *red_con_reader;
+    struct server_t *addr_customer;
+    struct customer_directory_t customers;
+    struct customer_connection_t *routes[MAX_CUSTOMERS];
+    struct customer_connection_t *connections;
+    uint64_t acks;
+} notifier_t;
+
+typedef struct journal_header_t
+{
+    char magic[8];
+    uint64_t record_size;
+    uint64_t length;
+} journal_header_t;
+
+typedef struct journal_record_t
+{
+    uint64_t oid;
+    uint64_t t_client;
+    uint64_t t_server;
+    uint64_t operation;
+    price_t price;
+    uint64_t quantity;
+    uint64_t target_oid;
+    char cid[37];
+    char symbol[11];
+} journal_record_t;
+
+typedef struct journal_snapshot_header_t
+{
+    char magic[8];
+    uint64_t record_size;
+    uint64_t journal_length;
+    uint64_t last_oid;
+    uint64_t orders;
+} journal_snapshot_header_t;
+
+typedef struct journal_t
+{
+    int64_t fd;
+    char *map;
+    uint64_t capacity;
+    struct journal_header_t *header;
+    char snapshot_path[JOURNAL_PATH_LEN];
+    char snapshot_tmp_path[JOURNAL_PATH_LEN];
+    uint64_t snapshot_length;
+    int64_t snapshot_pid;
+} journal_t;
+
+typedef struct session_t
+{
+    int64_t sd;
+    char ip[INET_ADDRSTRLEN];
+    uint64_t port;
+    char read_buffer[ORDER_SESSION_BUFFER_LEN];
+    uint64_t read_length;
+    char *write_buffer;
+    uint64_t write_offset;
+    uint64_t write_length;
+    uint64_t write_capacity;
+    char cid[37];
+    bool is_logged_on;
+    bool is_ready;
+    bool is_closed;
+    struct session_t *next_ready;
+} session_t;
+
 // Message specifications
 typedef struct order_gateway_request_message_t
 {
@@ -81,4 +531,168 @@ typedef struct order_gateway_response_message_t
 
 } __attribute__((packed)) order_gateway_response_message_t;
 
+// Binary order entry messages, all integers are in network byte order. Message type is the first byte of the frame,
+// it is uppercase letter, so it doesn't collide with text orders, which start with lowercase customer id.
+typedef struct order_entry_logon_message_t
+{
+    char type;
+    char cid[36];
+
+} __attribute__((packed)) order_entry_logon_message_t;
+
+typedef struct order_entry_order_message_t
+{
+    char type;
+    uint64_t t_client;
+    uint8_t operation;
+    char symbol[SYMBOL_LEN];
+    uint64_t quantity;
+    uint64_t price;
+
+} __attribute__((packed)) order_entry_order_message_t;
+
+typedef struct order_entry_cancel_message_t
+{
+    char type;
+    uint64_t t_client;
+    uint64_t order_id;
+
+} __attribute__((packed)) order_entry_cancel_message_t;
+
+typedef struct order_entry_replace_message_t
+{
+    char type;
+    uint64_t t_client;
+    uint64_t order_id;
+    uint64_t quantity;
+    uint64_t price;
+
+} __attribute__((packed)) order_entry_replace_message_t;
+
+typedef struct order_entry_ack_message_t
+{
+    char type;
+    uint64_t t_client;
+    uint64_t order_id;
+    uint64_t ts_ack;
+
+} __attribute__((packed)) order_entry_ack_message_t;
+
+// Market data messages, all integers are in network byte order and timestamps are nanoseconds since midnight.
+// Datagram starts with the header and each message is prefixed with 2 bytes of its length.
+// Retransmission request has the same layout as the header, its response is the header followed by the messages.
+typedef struct md_packet_header_t
+{
+    char session[MD_SESSION_LEN];
+    uint64_t sequence;
+    uint16_t count;
+
+} __attribute__((packed)) md_packet_header_t;
+
+typedef struct md_system_event_message_t
+{
+    char type;
+    uint64_t timestamp;
+    char event_code;
+
+} __attribute__((packed)) md_system_event_message_t;
+
+typedef struct md_add_order_message_t
+{
+    char type;
+    uint64_t timestamp;
+    uint64_t order_id;
+    char side;
+    uint64_t shares;
+    char stock[SYMBOL_LEN];
+    uint64_t price;
+
+} __attribute__((packed)) md_add_order_message_t;
+
+typedef struct md_order_executed_message_t
+{
+    char type;
+    uint64_t timestamp;
+    uint64_t order_id;
+    uint64_t executed_shares;
+
+} __attribute__((packed)) md_order_executed_message_t;
+
+typedef struct md_order_cancel_message_t
+{
+    char type;
+    uint64_t timestamp;
+    uint64_t order_id;
+    uint64_t cancelled_shares;
+
+} __attribute__((packed)) md_order_cancel_message_t;
+
+typedef struct md_snapshot_message_t
+{
+    char type;
+    uint64_t timestamp;
+    char stock[SYMBOL_LEN];
+    uint64_t sequence;
+    uint64_t orders;
+
+} __attribute__((packed)) md_snapshot_message_t;
+
+typedef struct md_quote_message_t
+{
+    char type;
+    uint64_t timestamp;
+    char stock[SYMBOL_LEN];
+    uint64_t bid_price;
+    uint64_t bid_size;
+    uint64_t ask_price;
+    uint64_t ask_size;
+
+} __attribute__((packed)) md_quote_message_t;
+
+typedef struct md_trade_message_t
+{
+    char type;
+    uint64_t timestamp;
+    char side;
+    uint64_t shares;
+    char stock[SYMBOL_LEN];
+    uint64_t price;
+    uint64_t match_number;
+
+} __attribute__((packed)) md_trade_message_t;
+
+// Directory request is the number of symbols followed by the symbols, the response is the header followed
+// by all channels and by the channel of each requested symbol. Multicast groups are IPv4 addresses.
+typedef struct md_directory_request_t
+{
+    uint16_t count;
+
+} __attribute__((packed)) md_directory_request_t;
+
+typedef struct md_directory_header_t
+{
+    char session[MD_SESSION_LEN];
+    uint16_t channels;
+    uint16_t count;
+
+} __attribute__((packed)) md_directory_header_t;
+
+typedef struct md_directory_channel_t
+{
+    uint16_t channel;
+    uint32_t group;
+    uint16_t port;
+    uint32_t snapshot_group;
+    uint16_t snapshot_port;
+    uint16_t rewind_port;
+
+} __attribute__((packed)) md_directory_channel_t;
+
+typedef struct md_directory_symbol_t
+{
+    char stock[SYMBOL_LEN];
+    uint16_t channel;
+
+} __attribute__((packed)) md_directory_symbol_t;
+
 #endif /* _MY_HEADER_H_ */
\ No newline at end of file